@@ -0,0 +1,266 @@
+#include "synthetic.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <vector>
+
+namespace
+{
+using namespace GraphSeg;
+
+constexpr int BenchDim = 300;
+constexpr Lang BenchLang = Lang::EN;
+
+using BenchGraph = graph::UndirectedGraph<BenchLang>;
+using BenchEmbedding = Embedding<BenchDim, BenchLang>;
+using BenchSegmentable = internal::Segmentable<BenchGraph, BenchDim, BenchLang>;
+
+/// <summary>
+/// similarity of two sentences of the given term count
+/// </summary>
+void BM_GetSimilarity(benchmark::State &state)
+{
+  std::mt19937 rng(42);
+  const auto length = static_cast<size_t>(state.range(0));
+  const auto sentences =
+      bench::GenerateSentences<BenchLang>(2, rng, length, length);
+  const auto embedding =
+      bench::GenerateEmbedding<BenchDim, BenchLang>(sentences, rng);
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(
+        embedding.GetSimilarity(sentences[0], sentences[1]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetSimilarity)->RangeMultiplier(4)->Range(8, 128);
+
+/// <summary>
+/// same as BM_GetSimilarity with dimension taken at runtime (DynamicDim):
+/// unrolled kernels for 50/100/200/300, generic loop for the others
+/// </summary>
+void BM_GetSimilarityDynamic(benchmark::State &state)
+{
+  std::mt19937 rng(42);
+  const auto length = static_cast<size_t>(state.range(0));
+  const auto dimension = static_cast<size_t>(state.range(1));
+  const auto sentences =
+      bench::GenerateSentences<BenchLang>(2, rng, length, length);
+  const auto embedding = bench::GenerateEmbedding<DynamicDim, BenchLang>(
+      sentences, rng, dimension);
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(
+        embedding.GetSimilarity(sentences[0], sentences[1]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetSimilarityDynamic)
+    ->ArgsProduct({{32}, {50, 64, 100, 200, 300}});
+
+/// <summary>
+/// all-pairs similarity and edge construction, threshold chosen for the
+/// requested edge density (percent)
+/// </summary>
+void BM_SetEdges(benchmark::State &state)
+{
+  std::mt19937 rng(42);
+  const auto size = static_cast<size_t>(state.range(0));
+  const auto density = static_cast<double>(state.range(1)) / 100.0;
+  const auto sentences = bench::GenerateSentences<BenchLang>(size, rng);
+  const auto embedding =
+      bench::GenerateEmbedding<BenchDim, BenchLang>(sentences, rng);
+  const auto threshold =
+      bench::ThresholdForDensity(embedding, sentences, density, rng);
+
+  BenchGraph graph(sentences);
+  for (auto _ : state)
+  {
+    graph.SetNode();
+    for (size_t i = 0; i < size; ++i)
+    {
+      for (size_t j = i + 1; j < size; ++j)
+      {
+        const auto sim = embedding.GetSimilarity(sentences[i], sentences[j]);
+        if (sim > threshold)
+        {
+          graph.SetEdge(static_cast<int>(i), static_cast<int>(j), sim);
+        }
+      }
+    }
+    benchmark::ClobberMemory();
+  }
+  state.counters["edges"] = static_cast<double>(bench::CountEdges(graph));
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(size * (size - 1) / 2));
+}
+BENCHMARK(BM_SetEdges)
+    ->ArgsProduct({{16, 64, 256}, {1, 5, 20}})
+    ->Unit(benchmark::kMillisecond);
+
+/// <summary>
+/// all-pairs scores of a document by policy: every term pair
+/// (TermPairSimilarity) against one Gram matrix of sentence centroids
+/// (CentroidSimilarity)
+/// </summary>
+template <class Policy> void BM_ScoreAllPairs(benchmark::State &state)
+{
+  std::mt19937 rng(42);
+  const auto size = static_cast<size_t>(state.range(0));
+  const auto sentences = bench::GenerateSentences<BenchLang>(size, rng);
+  const auto embedding =
+      bench::GenerateEmbedding<BenchDim, BenchLang>(sentences, rng);
+
+  for (auto _ : state)
+  {
+    typename Policy::template Scorer<BenchDim, BenchLang> scorer(embedding,
+                                                                 sentences);
+    double sum = 0.0;
+    for (size_t i = 0; i < size; ++i)
+    {
+      for (size_t j = i + 1; j < size; ++j)
+      {
+        sum += scorer.Similarity(i, j);
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(size * (size - 1) / 2));
+}
+BENCHMARK_TEMPLATE(BM_ScoreAllPairs, TermPairSimilarity)
+    ->Arg(16)
+    ->Arg(64)
+    ->Arg(256)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ScoreAllPairs, CentroidSimilarity)
+    ->Arg(16)
+    ->Arg(64)
+    ->Arg(256)
+    ->Unit(benchmark::kMillisecond);
+
+/// <summary>
+/// Bron-Kerbosch on graphs with local edges of the given density (percent)
+/// </summary>
+void BM_SetMaximumClique(benchmark::State &state)
+{
+  std::mt19937 rng(42);
+  const auto size = static_cast<size_t>(state.range(0));
+  const auto density = static_cast<double>(state.range(1)) / 100.0;
+  const auto sentences =
+      bench::GenerateSentences<BenchLang>(size, rng, 1, 1);
+
+  BenchGraph base(sentences);
+  bench::SetLocalEdges(base, density, rng);
+
+  size_t cliques = 0;
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    auto graph = base;
+    state.ResumeTiming();
+    graph.SetMaximumClique();
+    cliques = graph.GetMaximumClique().size();
+  }
+  state.counters["edges"] = static_cast<double>(bench::CountEdges(base));
+  state.counters["cliques"] = static_cast<double>(cliques);
+}
+BENCHMARK(BM_SetMaximumClique)
+    ->ArgsProduct({{10, 100, 1000, 10000, 50000}, {5, 20}})
+    // dense graphs blow up combinatorially, keep them small
+    ->Args({10, 50})
+    ->Args({100, 50})
+    ->Unit(benchmark::kMillisecond);
+
+/// <summary>
+/// init / merge / small segment phases on a graph with precomputed cliques
+/// </summary>
+void BM_ConstructSegment(benchmark::State &state)
+{
+  std::mt19937 rng(42);
+  const auto size = static_cast<size_t>(state.range(0));
+  const auto density = static_cast<double>(state.range(1)) / 100.0;
+  const auto sentences = bench::GenerateSentences<BenchLang>(size, rng);
+  const auto embedding =
+      bench::GenerateEmbedding<BenchDim, BenchLang>(sentences, rng);
+
+  auto graph = std::make_shared<BenchGraph>(sentences);
+  bench::SetLocalEdges(*graph, density, rng);
+  graph->SetMaximumClique();
+
+  size_t segments = 0;
+  for (auto _ : state)
+  {
+    BenchSegmentable segmentable(graph);
+    segmentable.ConstructSegment(embedding);
+    segments = segmentable.segments.size();
+  }
+  state.counters["cliques"] =
+      static_cast<double>(graph->GetMaximumClique().size());
+  state.counters["segments"] = static_cast<double>(segments);
+}
+BENCHMARK(BM_ConstructSegment)
+    ->ArgsProduct({{10, 100, 1000, 10000}, {5, 20}})
+    ->Unit(benchmark::kMillisecond);
+
+/// <summary>
+/// edges, cliques and segments of a whole document by container graph:
+/// UndirectedGraph against BitGraph of documents of at most 64 sentences
+/// </summary>
+template <class Graph> void BM_SmallDocument(benchmark::State &state)
+{
+  std::mt19937 rng(42);
+  const auto size = static_cast<size_t>(state.range(0));
+  const auto sentences = bench::GenerateSentences<BenchLang>(size, rng);
+  auto embedding = std::make_shared<BenchEmbedding>(
+      bench::GenerateEmbedding<BenchDim, BenchLang>(sentences, rng));
+  embedding->Freeze();
+  using Container = SegmentationContainer<Graph, BenchDim, BenchLang,
+                                          CentroidSimilarity>;
+  // threshold keeping 5% of pairs as edges
+  const auto scores = Container(sentences, embedding).ComputeSimilarityMatrix();
+  std::vector<double> similarities;
+  for (size_t i = 0; i < size; ++i)
+  {
+    for (size_t j = i + 1; j < size; ++j)
+    {
+      similarities.emplace_back(scores.Get(i, j));
+    }
+  }
+  std::sort(similarities.begin(), similarities.end());
+  const auto threshold = similarities[static_cast<size_t>(
+      0.95 * static_cast<double>(similarities.size() - 1))];
+
+  std::vector<std::byte> buffer(1 << 20);
+  size_t segments = 0;
+  for (auto _ : state)
+  {
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+    Container container(sentences, embedding, &arena);
+    container.SetThreshold(threshold);
+    container.SetGraph();
+    container.Segmentation();
+    segments = container.GetSegment().size();
+  }
+  state.counters["segments"] = static_cast<double>(segments);
+}
+BENCHMARK_TEMPLATE(BM_SmallDocument, BenchGraph)
+    ->Arg(16)
+    ->Arg(32)
+    ->Arg(64)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_SmallDocument, graph::BitGraph<BenchLang, 1>)
+    ->Arg(16)
+    ->Arg(32)
+    ->Arg(64)
+    ->Unit(benchmark::kMicrosecond);
+} // namespace
+
+BENCHMARK_MAIN();
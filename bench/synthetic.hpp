@@ -0,0 +1,175 @@
+#ifndef GRAPHSEG_CPP_BENCH_SYNTHETIC_HPP
+#define GRAPHSEG_CPP_BENCH_SYNTHETIC_HPP
+
+#include "graphseg/graphseg.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace GraphSeg::bench {
+/// <summary>
+/// vocabulary of synthetic documents. terms are grouped by topic, terms of
+/// the same topic have similar vectors
+/// </summary>
+static constexpr size_t VocabularySize = 20000;
+static constexpr size_t TopicVocabularySize = 50;
+static constexpr size_t TopicLength = 8;
+
+inline std::string TermName(size_t idx) { return "w" + std::to_string(idx); }
+
+/// <summary>
+/// generate n sentences. consecutive TopicLength sentences share a topic, so
+/// the document has segment structure
+/// </summary>
+template <Lang LangType>
+std::vector<Sentence<LangType>> GenerateSentences(size_t n, std::mt19937 &rng,
+                                                  size_t min_length = 5,
+                                                  size_t max_length = 25) {
+  std::uniform_int_distribution<size_t> length(min_length, max_length);
+  std::uniform_int_distribution<size_t> topic_base(
+      0, VocabularySize / TopicVocabularySize - 1);
+  std::uniform_int_distribution<size_t> topic_term(0,
+                                                   TopicVocabularySize - 1);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+  std::vector<Sentence<LangType>> sentences;
+  sentences.reserve(n);
+  size_t topic = topic_base(rng);
+  for (size_t i = 0; i < n; ++i) {
+    if (i % TopicLength == 0) {
+      topic = topic_base(rng);
+    }
+    std::string text;
+    const auto terms = length(rng);
+    for (size_t j = 0; j < terms; ++j) {
+      size_t idx;
+      if (uniform(rng) < 0.6) {
+        idx = topic * TopicVocabularySize + topic_term(rng);
+      } else {
+        // zipf-like background terms
+        idx = std::min(VocabularySize - 1,
+                       static_cast<size_t>(std::exp(
+                           uniform(rng) *
+                           std::log(static_cast<double>(VocabularySize)))));
+      }
+      if (j != 0) {
+        text += ' ';
+      }
+      text += TermName(idx);
+    }
+    sentences.emplace_back(text);
+  }
+  return sentences;
+}
+
+/// <summary>
+/// build embedding of sentences in-process: random topic-correlated vectors
+/// (about 5% zero vectors, treated as stop words) and random corpus counts.
+/// dimension must be given for DynamicDim
+/// </summary>
+template <int VectorDim, Lang LangType>
+Embedding<VectorDim, LangType>
+GenerateEmbedding(const std::vector<Sentence<LangType>> &sentences,
+                  std::mt19937 &rng, size_t dimension = VectorDim) {
+  std::normal_distribution<float> normal(0.0f, 1.0f);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+  std::vector<float> topics(VocabularySize / TopicVocabularySize * dimension);
+  for (auto &v : topics) {
+    v = normal(rng);
+  }
+
+  std::vector<std::string> terms;
+  std::vector<float> rows;
+  std::unordered_map<std::string, uint32_t> counts;
+  terms.reserve(VocabularySize);
+  rows.reserve(VocabularySize * dimension);
+  for (size_t i = 0; i < VocabularySize; ++i) {
+    const auto stop_word = uniform(rng) < 0.05;
+    const auto topic = i / TopicVocabularySize;
+    for (size_t d = 0; d < dimension; ++d) {
+      rows.emplace_back(stop_word ? 0.0f
+                                  : topics[topic * dimension + d] +
+                                        0.8f * normal(rng));
+    }
+    terms.emplace_back(TermName(i));
+    counts[terms.back()] = static_cast<uint32_t>(
+        std::exp(uniform(rng) * std::log(100000.0)));
+  }
+
+  std::ostringstream os;
+  internal::VectorFormat::Write(os, terms, rows,
+                                static_cast<uint32_t>(dimension));
+  const auto buffer = os.str();
+
+  Embedding<VectorDim, LangType> embedding;
+  for (const auto &sentence : sentences) {
+    embedding.AddSentenceWords(sentence);
+  }
+  embedding.LoadWordEmbeddings(
+      internal::VectorFormatView(buffer.data(), buffer.size()));
+  embedding.SetInformationContentTable(internal::ICTable::FromCounts(counts));
+  embedding.UpdateInformationContent();
+  return embedding;
+}
+
+/// <summary>
+/// similarity threshold giving approximately the requested edge density,
+/// estimated from sampled sentence pairs
+/// </summary>
+template <int VectorDim, Lang LangType>
+double ThresholdForDensity(const Embedding<VectorDim, LangType> &embedding,
+                           const std::vector<Sentence<LangType>> &sentences,
+                           double density, std::mt19937 &rng,
+                           size_t samples = 2000) {
+  std::uniform_int_distribution<size_t> pick(0, sentences.size() - 1);
+  std::vector<double> similarities;
+  similarities.reserve(samples);
+  for (size_t i = 0; i < samples; ++i) {
+    const auto a = pick(rng);
+    const auto b = pick(rng);
+    if (a != b) {
+      similarities.emplace_back(
+          embedding.GetSimilarity(sentences[a], sentences[b]));
+    }
+  }
+  std::sort(similarities.begin(), similarities.end());
+  const auto idx = static_cast<size_t>(
+      (1.0 - density) * static_cast<double>(similarities.size() - 1));
+  return similarities[idx];
+}
+
+/// <summary>
+/// connect sentences closer than window with probability density.
+/// coherent documents mostly relate nearby sentences
+/// </summary>
+template <class Graph>
+void SetLocalEdges(Graph &graph, double density, std::mt19937 &rng,
+                   size_t window = 32) {
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  graph.SetNode();
+  const size_t size = graph.GetGraphSize();
+  for (size_t i = 0; i < size; ++i) {
+    for (size_t j = i + 1; j < std::min(size, i + window + 1); ++j) {
+      if (uniform(rng) < density) {
+        graph.SetEdge(static_cast<int>(i), static_cast<int>(j), 1.0);
+      }
+    }
+  }
+}
+
+template <class Graph> size_t CountEdges(const Graph &graph) {
+  size_t edges = 0;
+  for (size_t i = 0; i < graph.GetGraphSize(); ++i) {
+    edges += graph[i].size();
+  }
+  return edges / 2;
+}
+} // namespace GraphSeg::bench
+
+#endif
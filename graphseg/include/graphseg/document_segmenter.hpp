@@ -0,0 +1,304 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_DOCUMENT_SEGMENTER_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_DOCUMENT_SEGMENTER_HPP
+
+#include "graphseg/embedding.hpp"
+#include "graphseg/graph/bit_graph.hpp"
+#include "graphseg/internal/ic_table.hpp"
+#include "graphseg/internal/segment_cache.hpp"
+#include "graphseg/internal/segmentation_stats.hpp"
+#include "graphseg/internal/shared_vocabulary.hpp"
+#include "graphseg/internal/vector_store.hpp"
+#include "graphseg/language.hpp"
+#include "graphseg/segmentation_container.hpp"
+#include "graphseg/sentence.hpp"
+#include "graphseg/similarity_policy.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace GraphSeg {
+/// <summary>
+/// settings of PipelineConfig and ServerConfig that decide how a document
+/// is embedded, segmented and cached
+/// </summary>
+struct SegmenterConfig {
+  /// <summary>
+  /// edge threshold passed to SegmentationContainer
+  /// </summary>
+  double threshold = 0.0;
+
+  /// <summary>
+  /// maximum edges per sentence, 0 for no limit (see SetEdgeBudget)
+  /// </summary>
+  double edge_budget = 0.0;
+
+  /// <summary>
+  /// minimum segment size passed to SegmentationContainer
+  /// </summary>
+  size_t minimum_segment_size = 2;
+
+  /// <summary>
+  /// maximal clique search, GREEDY caps the cost of any document
+  /// </summary>
+  graph::CliqueMode clique_mode = graph::CliqueMode::EXACT;
+
+  /// <summary>
+  /// CLIQUE, or COHERENCE with segments of at most maximum_segment_length
+  /// sentences (0: no limit) for long documents
+  /// </summary>
+  SegmentationEngine engine = SegmentationEngine::CLIQUE;
+  size_t maximum_segment_length = 0;
+
+  /// <summary>
+  /// let each document choose edge band and clique mode by cost model
+  /// (see SetAutomaticPlan), overriding clique_mode
+  /// </summary>
+  bool automatic_plan = false;
+
+  /// <summary>
+  /// segment documents of at most 128 sentences on graph::BitGraph in
+  /// place of Graph: same segments, without sets or adjacency lists
+  /// </summary>
+  bool small_documents = true;
+
+  /// <summary>
+  /// time from receiving a document (read from file or request) to its
+  /// segments, 0 for no limit. past it segmentation falls back to cheaper
+  /// work and the result is flagged degraded (see
+  /// SegmentationContainer::SetDeadline)
+  /// </summary>
+  std::chrono::milliseconds deadline{0};
+
+  /// <summary>
+  /// bytes of the per-thread buffer backing the arena of one document.
+  /// larger documents spill over to the default heap
+  /// </summary>
+  size_t arena_size = 1 << 20;
+
+  /// <summary>
+  /// precomputed information content, frequency.py is used if null
+  /// </summary>
+  std::shared_ptr<const internal::ICTable> ic_table;
+
+  /// <summary>
+  /// preloaded model, vectorizer.py is used if null
+  /// </summary>
+  std::shared_ptr<const internal::VectorStore> vectors;
+
+  /// <summary>
+  /// terms resolved by earlier documents, taken from vectors or
+  /// vectorizer.py only when unseen. null to resolve every document alone
+  /// </summary>
+  std::shared_ptr<internal::SharedVocabulary> vocabulary;
+
+  /// <summary>
+  /// results of earlier documents with the same normalized text, null to
+  /// segment every document
+  /// </summary>
+  std::shared_ptr<internal::SegmentCache> cache;
+
+  /// <summary>
+  /// identifies vectors and information content in cache keys; change it
+  /// whenever the model changes
+  /// </summary>
+  std::string model_id;
+};
+
+/// <summary>
+/// "sentences":N,"segments":[[begin,end],...] with [begin, end) sentence
+/// offsets, followed by "degraded":true if the deadline cut segmentation
+/// short. members of the JSON objects of graphseg and graphseg_server
+/// </summary>
+inline std::string
+SegmentationJson(size_t sentences,
+                 const std::vector<std::vector<internal::Vertex>> &segments,
+                 bool degraded = false) {
+  std::string json = "\"sentences\":" + std::to_string(sentences) +
+                     ",\"segments\":[";
+  bool first = true;
+  for (const auto &segment : segments) {
+    if (segment.empty()) {
+      continue;
+    }
+    const auto [begin, end] =
+        std::minmax_element(segment.begin(), segment.end());
+    json += first ? "[" : ",[";
+    json += std::to_string(*begin) + "," + std::to_string(*end + 1) + "]";
+    first = false;
+  }
+  return json + (degraded ? "],\"degraded\":true" : "]");
+}
+
+/// <summary>
+/// Steps from tagged sentences to segments that Pipeline and Server share,
+/// so both key, embed and segment a document the same way. config must
+/// outlive the segmenter
+/// </summary>
+template <class Graph, int VectorDim, Lang LangType = Lang::EN,
+          class SimilarityPolicy = TermPairSimilarity>
+class DocumentSegmenter {
+public:
+  using SentenceType = Sentence<LangType>;
+  using EmbeddingType = Embedding<VectorDim, LangType>;
+  using Container =
+      SegmentationContainer<Graph, VectorDim, LangType, SimilarityPolicy>;
+
+  /// <summary>
+  /// container of documents with at most 64 Words sentences
+  /// </summary>
+  template <size_t Words>
+  using SmallContainer =
+      SegmentationContainer<graph::BitGraph<LangType, Words>, VectorDim,
+                            LangType, SimilarityPolicy>;
+
+  struct Result {
+    std::vector<std::vector<internal::Vertex>> segments;
+    SegmentationStats stats;
+
+    /// <summary>
+    /// segments were cut short by the deadline; not cached
+    /// </summary>
+    bool degraded = false;
+  };
+
+  explicit DocumentSegmenter(const SegmenterConfig &_config)
+      : config(_config) {}
+
+  /// <summary>
+  /// cache key of text under config. kind tells apart inputs that are
+  /// split differently (see SegmentCache::MakeKey)
+  /// </summary>
+  template <class CharT>
+  internal::SegmentCacheKey MakeKey(const std::basic_string<CharT> &text,
+                                    uint32_t kind = 0) const {
+    return internal::SegmentCache::MakeKey(
+        text, config.threshold, config.edge_budget,
+        config.minimum_segment_size, config.model_id, kind,
+        {static_cast<uint64_t>(config.clique_mode),
+         static_cast<uint64_t>(config.engine), config.maximum_segment_length,
+         static_cast<uint64_t>(config.automatic_plan),
+         uint64_t{SimilarityPolicy::ID}});
+  }
+
+  /// <summary>
+  /// store result under key unless the deadline cut it short
+  /// </summary>
+  void Remember(const internal::SegmentCacheKey &key, size_t sentences,
+                const Result &result) const {
+    if (config.cache && !result.degraded) {
+      config.cache->Insert(key, {sentences, result.segments});
+    }
+  }
+
+  /// <summary>
+  /// deadline of a document received now, none if config has no limit
+  /// </summary>
+  std::optional<std::chrono::steady_clock::time_point> Deadline() const {
+    if (config.deadline.count() <= 0) {
+      return std::nullopt;
+    }
+    return std::chrono::steady_clock::now() + config.deadline;
+  }
+
+  /// <summary>
+  /// frozen embedding of the terms of sentences, shared with containers
+  /// </summary>
+  std::shared_ptr<const EmbeddingType>
+  Embed(const std::vector<SentenceType> &sentences) const {
+    auto shared = std::make_shared<EmbeddingType>();
+    auto &embedding = *shared;
+    embedding.SetInformationContentTable(config.ic_table);
+    for (const auto &sentence : sentences) {
+      embedding.AddSentenceWords(sentence);
+    }
+    if (config.vocabulary) {
+      embedding.LoadWordEmbeddings(config.vocabulary, config.vectors.get());
+    } else if (config.vectors) {
+      embedding.LoadWordEmbeddings(*config.vectors);
+      embedding.UpdateInformationContent();
+    } else {
+      embedding.GetWordEmbeddings();
+    }
+    embedding.Freeze();
+    return shared;
+  }
+
+  /// <summary>
+  /// segments of sentences, graph work allocates from resource. visit is
+  /// called with the container once it is segmented (documents of two
+  /// sentences or more only)
+  /// </summary>
+  template <class Visit>
+  Result Segment(const std::vector<SentenceType> &sentences,
+                 std::shared_ptr<const EmbeddingType> embedding,
+                 std::optional<std::chrono::steady_clock::time_point> deadline,
+                 std::pmr::memory_resource *resource, Visit &&visit) const {
+    // a graph needs at least two vertices
+    if (sentences.size() < 2) {
+      Result result;
+      if (sentences.size() == 1) {
+        result.segments = {{0}};
+      }
+      return result;
+    }
+    const auto words =
+        config.small_documents ? graph::BitGraphWords(sentences.size()) : 0;
+    if (words == 1) {
+      return SegmentWith<SmallContainer<1>>(sentences, std::move(embedding),
+                                            deadline, resource, visit);
+    } else if (words == 2) {
+      return SegmentWith<SmallContainer<2>>(sentences, std::move(embedding),
+                                            deadline, resource, visit);
+    }
+    return SegmentWith<Container>(sentences, std::move(embedding), deadline,
+                                  resource, visit);
+  }
+
+  Result Segment(const std::vector<SentenceType> &sentences,
+                 std::shared_ptr<const EmbeddingType> embedding,
+                 std::optional<std::chrono::steady_clock::time_point> deadline,
+                 std::pmr::memory_resource *resource) const {
+    return Segment(sentences, std::move(embedding), deadline, resource,
+                   [](const auto &) {});
+  }
+
+private:
+  template <class SegmentContainer, class Visit>
+  Result
+  SegmentWith(const std::vector<SentenceType> &sentences,
+              std::shared_ptr<const EmbeddingType> embedding,
+              std::optional<std::chrono::steady_clock::time_point> deadline,
+              std::pmr::memory_resource *resource, Visit &visit) const {
+    SegmentContainer container(sentences, std::move(embedding), resource);
+    container.SetThreshold(config.threshold);
+    container.SetEdgeBudget(config.edge_budget);
+    container.SetCliqueMode(config.clique_mode);
+    container.SetSegmentationEngine(config.engine);
+    container.SetMaximumSegmentLength(config.maximum_segment_length);
+    container.SetAutomaticPlan(config.automatic_plan);
+    container.SetMinimumSegmentSize(config.minimum_segment_size);
+    if (deadline) {
+      container.SetDeadline(*deadline);
+    }
+    container.SetGraph();
+    container.Segmentation();
+    Result result;
+    result.segments = container.ExportSegment();
+    result.stats = container.GetStats();
+    result.degraded = container.IsDegraded();
+    visit(container);
+    return result;
+  }
+
+  const SegmenterConfig &config;
+};
+} // namespace GraphSeg
+
+#endif
@@ -2,27 +2,58 @@
 #define GRAPHSEG_CPP_GRAPHSEG_EMBEDDING_HPP
 
 #include "graphseg/internal/frequency.hpp"
+#include "graphseg/internal/ic_table.hpp"
+#include "graphseg/internal/segmentation_stats.hpp"
+#include "graphseg/internal/shared_vocabulary.hpp"
+#include "graphseg/internal/vector_format.hpp"
+#include "graphseg/internal/vector_store.hpp"
 #include "graphseg/internal/utils/exec.hpp"
+#include "graphseg/internal/utils/trace.hpp"
+#include "graphseg/internal/utils/vector_kernel.hpp"
 #include "graphseg/language.hpp"
 #include "graphseg/sentence.hpp"
 
-#include <array>
+#include <algorithm>
+#include <functional>
+#include <limits>
 #include <memory>
-#include <rapidjson/document.h>
+#include <stdexcept>
+#include <string>
+#include <rapidjson/reader.h>
 #include <tuple>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace GraphSeg {
 using namespace rapidjson;
 using namespace internal;
 
+/// <summary>
+/// wire format of vectors returned by vectorizer.py
+/// </summary>
+enum class VectorTransport { JSON, BINARY };
+
+/// <summary>
+/// VectorDim taking the dimension of the loaded model at runtime, so one
+/// build serves models of any size
+/// </summary>
+static constexpr int DynamicDim = 0;
+
 template <int VectorDim, Lang LangType = Lang::EN>
 class Embedding : public Executable<LangType> {
+  static_assert(VectorDim >= 0, "VectorDim must be positive or DynamicDim");
+
 public:
   using Base = Executable<LangType>;
   using SentenceType = Sentence<LangType>;
-  using WordEmbedding = std::array<double, VectorDim>;
+
+  /// <summary>
+  /// row in vector storage, occurrence count and information content of a
+  /// term
+  /// </summary>
+  using TermEntry = std::tuple<size_t, unsigned int, double>;
 
   Embedding() = default;
 
@@ -33,6 +64,8 @@ public:
             std::enable_if_t<std::is_same_v<std::remove_reference_t<T>,
                                             const SentenceType>> * = nullptr>
   void AddSentenceWords(T &&s) {
+    CheckMutable();
+    GRAPHSEG_STATS_PHASE(stats, SegmentationPhase::VOCABULARY);
     auto tmp = std::forward<T>(s);
     for (const auto &term : tmp) {
       if (!exists(term)) {
@@ -48,30 +81,211 @@ public:
   /// Get all word embedding
   /// </summary>
   void GetWordEmbeddings() {
+    CheckMutable();
+    GRAPHSEG_TRACE_SCOPE("Embedding::GetWordEmbeddings");
+    GRAPHSEG_STATS_PHASE(stats, SegmentationPhase::EMBEDDING);
     const std::string term_stream = GetTermStream();
-    auto result = Base::Execute("vectorizer.py", term_stream);
-    Document doc;
-    const auto parse_result = doc.Parse(result.c_str()).HasParseError();
-    assert(parse_result == false);
-    for (auto itr = doc.MemberBegin(); itr != doc.MemberEnd(); ++itr) {
-      const auto term = itr->name.GetString();
-      assert(doc.HasMember(term));
-      const auto &get_vector = doc[term];
-      for (SizeType i = 0; i < VectorDim; ++i) {
-        std::get<0>(words[term])[static_cast<size_t>(i)] =
-            get_vector[i].GetDouble();
+    if (transport == VectorTransport::BINARY) {
+      const auto result = Base::ExecuteBinary("vectorizer.py", term_stream);
+      LoadWordEmbeddings(VectorFormatView(result.data(), result.size()));
+    } else {
+      EmbeddingHandler handler(*this);
+      Base::Execute("vectorizer.py", term_stream, handler);
+      UpdateNorms();
+    }
+    UpdateInformationContent();
+  }
+
+  /// <summary>
+  /// Compute information content of added terms, from the table if it is
+  /// set, otherwise from frequency.py counts
+  /// </summary>
+  void UpdateInformationContent() {
+    CheckMutable();
+    if (ic_table) {
+      for (auto &[term, entry] : words) {
+        std::get<2>(entry) = ic_table->InformationContent(term);
+      }
+    } else {
+      frequency = std::make_unique<Frequency<LangType>>(GetTermStream());
+      for (auto &[term, entry] : words) {
+        std::get<2>(entry) = ICTable::InformationContent(
+            frequency->GetFrequency(term), frequency->GetCorpusSize(),
+            frequency->GetTotalCount());
+      }
+    }
+  }
+
+  /// <summary>
+  /// Use precomputed information content table (see graphseg_ic_table)
+  /// instead of running frequency.py
+  /// </summary>
+  void SetInformationContentTable(std::shared_ptr<const ICTable> table) {
+    CheckMutable();
+    ic_table = std::move(table);
+  }
+
+  /// <summary>
+  /// Fill embeddings of added terms from VectorFormat buffer, e.g. output of
+  /// an external vectorizer or a mapped model file
+  /// </summary>
+  void LoadWordEmbeddings(const VectorFormatView &view) {
+    CheckMutable();
+    SetDimension(view.Dimension());
+    if (view.Size() <= words.size()) {
+      for (size_t i = 0; i < view.Size(); ++i) {
+        auto itr = words.find(std::string(view.Term(i)));
+        if (itr != words.end()) {
+          view.CopyRow(i, StorageRow(std::get<0>(itr->second)));
+        }
+      }
+    } else {
+      // large store: look up only our own terms
+      const auto index = view.BuildIndex();
+      for (auto &[term, entry] : words) {
+        auto itr = index.find(term);
+        if (itr != index.end()) {
+          view.CopyRow(itr->second, StorageRow(std::get<0>(entry)));
+        }
+      }
+    }
+    UpdateNorms();
+  }
+
+  /// <summary>
+  /// Fill embeddings of added terms from preloaded model. terms missing in
+  /// the store keep zero vectors (treated as stop words)
+  /// </summary>
+  void LoadWordEmbeddings(const VectorStore &store) {
+    CheckMutable();
+    GRAPHSEG_STATS_PHASE(stats, SegmentationPhase::EMBEDDING);
+    SetDimension(store.Dimension());
+    for (auto &[term, entry] : words) {
+      if (const auto row = store.Find(term)) {
+        store.CopyRow(*row, StorageRow(std::get<0>(entry)));
+      }
+    }
+    UpdateNorms();
+  }
+
+  /// <summary>
+  /// Take vectors and information content of added terms from vocabulary
+  /// shared by all documents of the process, without copying them. Terms
+  /// it does not hold yet are fetched as GetWordEmbeddings() does, or from
+  /// store if given, and published for later documents.
+  /// UpdateInformationContent() must not be called afterwards
+  /// </summary>
+  void LoadWordEmbeddings(std::shared_ptr<SharedVocabulary> shared,
+                          const VectorStore *store = nullptr) {
+    CheckMutable();
+    GRAPHSEG_TRACE_SCOPE("Embedding::LoadWordEmbeddings");
+    GRAPHSEG_STATS_PHASE(stats, SegmentationPhase::EMBEDDING);
+    Embedding fetched;
+    fetched.transport = transport;
+    fetched.ic_table = ic_table;
+    for (const auto &word : words) {
+      if (shared->Find(word.first) == nullptr) {
+        fetched.InitWordEmbedding(word.first);
       }
     }
+    shared->CountLookups(words.size() - fetched.words.size(),
+                         fetched.words.size());
+    if (!fetched.words.empty()) {
+      // documents racing on the same new term publish the first result
+      if (store != nullptr) {
+        fetched.LoadWordEmbeddings(*store);
+        fetched.UpdateInformationContent();
+      } else {
+        fetched.GetWordEmbeddings();
+      }
+      for (const auto &[term, entry] : fetched.words) {
+        const auto row = std::get<0>(entry);
+        shared->Publish(term,
+                        fetched.dimension == 0 ? nullptr : fetched.Row(row),
+                        fetched.dimension, std::get<2>(entry));
+      }
+    }
+
+    if (shared->Dimension() != 0) {
+      FixDimension(shared->Dimension());
+    }
+    vectors.clear();
+    vectors.shrink_to_fit();
+    rows.resize(words.size());
+    for (auto &[term, entry] : words) {
+      const auto *published = shared->Find(term);
+      const auto row = std::get<0>(entry);
+      rows[row] = published->vector;
+      norms[row] = published->norm;
+      std::get<2>(entry) = published->information_content;
+    }
+    vocabulary = std::move(shared);
+  }
+
+  /// <summary>
+  /// Fix vector dimension. With DynamicDim it is taken from the first
+  /// loaded model; loading a model of another dimension afterwards throws
+  /// </summary>
+  void SetDimension(size_t d) {
+    CheckMutable();
+    FixDimension(d);
+    vectors.resize(words.size() * dimension, 0.0);
+  }
+
+  /// <summary>
+  /// Finish the embedding once its vectors and information content are
+  /// loaded: frequency counts are dropped and storage is compacted. Members
+  /// that change the embedding throw std::logic_error afterwards, so one
+  /// frozen instance can be read by any number of segmentation threads
+  /// without locks or copies (see SegmentationContainer taking
+  /// std::shared_ptr<const Embedding>)
+  /// </summary>
+  void Freeze() {
+    frequency.reset();
+    vectors.shrink_to_fit();
+    norms.shrink_to_fit();
+    rows.shrink_to_fit();
+    frozen = true;
+  }
+
+  bool IsFrozen() const noexcept { return frozen; }
+
+  /// <summary>
+  /// dimension of word vectors, 0 until a model is loaded with DynamicDim
+  /// </summary>
+  size_t Dimension() const noexcept { return dimension; }
+
+  /// <summary>
+  /// Select how vectorizer.py sends vectors back
+  /// </summary>
+  inline void SetVectorTransport(VectorTransport t) noexcept {
+    transport = t;
+  }
 
-    frequency = std::make_unique<Frequency<LangType>>(term_stream);
+  /// <summary>
+  /// Get word vector (Dimension() values)
+  /// </summary>
+  const double *GetVector(const std::string &term) const {
+    return Row(std::get<0>(words.at(term)));
   }
 
   /// <summary>
-  /// Get word vector
+  /// Distinct scoring terms of a sentence: row, occurrence count in the
+  /// sentence and information content, same layout as TermEntry. stop
+  /// words and terms without a vector are left out
   /// </summary>
-  GRAPHSEG_INLINE_CONST WordEmbedding &
-  GetVector(const std::string &term) const {
-    return std::get<0>(words.at(term));
+  using TermBag = std::vector<TermEntry>;
+
+  TermBag GetTermBag(const SentenceType &s) const {
+    TermBag bag;
+    bag.reserve(s.GetTermCounts().size());
+    for (const auto &[term, count] : s.GetTermCounts()) {
+      const auto &entry = words.at(term);
+      if (!IsStopWord(std::get<0>(entry))) {
+        bag.emplace_back(std::get<0>(entry), count, std::get<2>(entry));
+      }
+    }
+    return bag;
   }
 
   /// <summary>
@@ -79,20 +293,105 @@ public:
   /// </summary>
   double GetSimilarity(const SentenceType &sg1,
                        const SentenceType &sg2) const & {
+    return GetSimilarity(GetTermBag(sg1), GetTermBag(sg2));
+  }
+
+  /// <summary>
+  /// same as GetSimilarity of the sentences, a term occurring k and m
+  /// times is scored once and counted k * m times
+  /// </summary>
+  double GetSimilarity(const TermBag &bag1, const TermBag &bag2) const & {
     double result = 0.0;
-    for (const auto &term : sg1.GetTerms()) {
-      for (const auto &target_term : sg2.GetTerms()) {
-        const auto &v1 = GetVector(term);
-        const auto &v2 = GetVector(target_term);
-        if (IsStopWord(v1) || IsStopWord(v2)) {
-          continue;
-        }
-        assert(v1.size() == v2.size());
-        auto sim =
-            CosineSimilarity(v1.cbegin(), v1.cend(), v2.cbegin(), v2.cend());
-        result += sim * std::min({InformationContent(term),
-                                  InformationContent(target_term)});
+    for (const auto &[row1, count1, ic1] : bag1) {
+      double weighted = 0.0;
+      for (const auto &[row2, count2, ic2] : bag2) {
+        const auto sim =
+            Dot(Row(row1), Row(row2)) / (norms[row1] * norms[row2]);
+        weighted += sim * std::min(ic1, ic2) * count2;
       }
+      result += weighted * count1;
+    }
+    return result;
+  }
+
+  /// <summary>
+  /// Write unit vector of sentence to out (Dimension() values): term vectors
+  /// normalized, weighted by information content, summed and normalized
+  /// again. zero if every term is a stop word
+  /// </summary>
+  void Centroid(const SentenceType &s, double *out) const {
+    std::fill_n(out, dimension, 0.0);
+    for (const auto &[row, count, ic] : GetTermBag(s)) {
+      utils::Axpy(count * ic / norms[row], Row(row), out, dimension);
+    }
+    const auto norm = utils::Norm(out, dimension);
+    if (norm > 0.0) {
+      for (size_t d = 0; d < dimension; ++d) {
+        out[d] /= norm;
+      }
+    }
+  }
+
+  /// <summary>
+  /// Step function of a sentence for SimilarityUpperBound: pairs (level,
+  /// norm) by descending information content level, norm being |Σ u_a|
+  /// over unit term vectors u_a whose information content is >= level.
+  /// empty if every term is a stop word, {+inf, +inf} if some information
+  /// content is negative and the bound does not hold
+  /// </summary>
+  using BoundProfile = std::vector<std::pair<double, double>>;
+
+  BoundProfile GetBoundProfile(const SentenceType &s) const {
+    auto bag = GetTermBag(s);
+    for (const auto &entry : bag) {
+      if (std::get<2>(entry) < 0.0) {
+        const auto inf = std::numeric_limits<double>::infinity();
+        return {{inf, inf}};
+      }
+    }
+    std::sort(bag.begin(), bag.end(), [](const auto &a, const auto &b) {
+      return std::get<2>(a) > std::get<2>(b);
+    });
+
+    BoundProfile profile;
+    std::vector<double> sum(dimension, 0.0);
+    for (size_t k = 0; k < bag.size(); ++k) {
+      const auto [row, count, ic] = bag[k];
+      utils::Axpy(count / norms[row], Row(row), sum.data(), dimension);
+      // terms of equal level enter the sum together
+      if (k + 1 == bag.size() || std::get<2>(bag[k + 1]) != ic) {
+        profile.emplace_back(ic, utils::Norm(sum.data(), dimension));
+      }
+    }
+    return profile;
+  }
+
+  /// <summary>
+  /// Upper bound of GetSimilarity in O(|p1| + |p2|). With min(x, y) =
+  /// ∫ [t < x][t < y] dt over t >= 0, similarity is ∫ A(t)·B(t) dt where
+  /// A(t), B(t) sum unit term vectors with information content above t;
+  /// Cauchy-Schwarz bounds the integrand by |A(t)| |B(t)|
+  /// </summary>
+  static double SimilarityUpperBound(const BoundProfile &p1,
+                                     const BoundProfile &p2) noexcept {
+    double result = 0.0;
+    size_t a = 0, b = 0;
+    // walk levels downward; on [next, level) both norms are constant
+    double level = std::max(p1.empty() ? 0.0 : p1.front().first,
+                            p2.empty() ? 0.0 : p2.front().first);
+    while (level > 0.0) {
+      while (a < p1.size() && p1[a].first >= level) {
+        ++a;
+      }
+      while (b < p2.size() && p2[b].first >= level) {
+        ++b;
+      }
+      const auto next = std::max(a < p1.size() ? p1[a].first : 0.0,
+                                 b < p2.size() ? p2[b].first : 0.0);
+      if (a > 0 && b > 0) {
+        result += (level - next) * p1[a - 1].second * p2[b - 1].second;
+      }
+      level = next;
     }
     return result;
   }
@@ -108,29 +407,109 @@ public:
     return (normalized_rel_1 + normalized_rel_2) / 2;
   }
 
+  /// <summary>
+  /// time spent on vocabulary and embedding fetch (GRAPHSEG_STATS only)
+  /// </summary>
+  GRAPHSEG_INLINE_CONST SegmentationStats &GetStats() const & {
+    return stats;
+  }
+
 private:
-  template <class ForwardIterator>
-  double CosineSimilarity(ForwardIterator _abegin, ForwardIterator _aend,
-                          ForwardIterator _bbegin,
-                          ForwardIterator _bend) const {
-    double q = 0, d = 0, qd = 0;
-    auto a = _abegin;
-    auto b = _bbegin;
-    while (a != _aend && b != _bend) {
-      q += pow(*a, 2);
-      d += pow(*b, 2);
-      qd += (*a) * (*b);
-      ++a;
-      ++b;
-    }
-    return qd / (std::sqrt(q) * std::sqrt(d));
-  }
-
-  double InformationContent(const std::string &term) const {
-    const double denominator = frequency->GetFrequency(term) + 1;
-    const double numerator =
-        frequency->GetCorpusSize() + frequency->GetTotalCount();
-    return -std::log(denominator / numerator);
+  /// <summary>
+  /// SAX handler writing {"term": [v0, v1, ...], ...} straight into
+  /// embeddings without building DOM
+  /// </summary>
+  class EmbeddingHandler
+      : public BaseReaderHandler<UTF8<>, EmbeddingHandler> {
+  public:
+    explicit EmbeddingHandler(Embedding &_embedding) : embedding(_embedding) {}
+
+    bool Key(const char *str, SizeType length, bool) {
+      auto itr = embedding.words.find(std::string(str, length));
+      current = itr == embedding.words.end() ? nullptr : &itr->second;
+      return true;
+    }
+
+    bool StartArray() {
+      row.clear();
+      return true;
+    }
+
+    bool Double(double d) {
+      row.emplace_back(d);
+      return true;
+    }
+
+    /// <summary>
+    /// first vector fixes dimension with DynamicDim, extra values of longer
+    /// vectors are ignored
+    /// </summary>
+    bool EndArray(SizeType) {
+      if (current != nullptr && !row.empty()) {
+        if (embedding.dimension == 0) {
+          embedding.SetDimension(row.size());
+        }
+        std::copy_n(row.begin(), std::min(row.size(), embedding.dimension),
+                    embedding.StorageRow(std::get<0>(*current)));
+      }
+      return true;
+    }
+
+    bool Int(int i) { return Double(i); }
+    bool Uint(unsigned u) { return Double(u); }
+    bool Int64(int64_t i) { return Double(static_cast<double>(i)); }
+    bool Uint64(uint64_t u) { return Double(static_cast<double>(u)); }
+
+  private:
+    Embedding &embedding;
+    TermEntry *current = nullptr;
+    std::vector<double> row;
+  };
+
+  double *StorageRow(size_t row) { return vectors.data() + row * dimension; }
+
+  /// <summary>
+  /// vector of row, in shared vocabulary if one was loaded. own storage is
+  /// addressed by offset so that copies of embedding stay valid
+  /// </summary>
+  const double *Row(size_t row) const {
+    return vocabulary ? rows[row] : vectors.data() + row * dimension;
+  }
+
+  /// <summary>
+  /// compile-time unrolled kernel for fixed VectorDim, the one selected by
+  /// SetDimension() for DynamicDim
+  /// </summary>
+  double Dot(const double *a, const double *b) const {
+    if constexpr (VectorDim != DynamicDim) {
+      return utils::Dot<VectorDim>(a, b);
+    } else {
+      return dot(a, b, dimension);
+    }
+  }
+
+  void UpdateNorms() {
+    for (size_t row = 0; row < norms.size(); ++row) {
+      norms[row] = dimension == 0 ? 0.0 : utils::Norm(Row(row), dimension);
+    }
+  }
+
+  void CheckMutable() const {
+    if (frozen) {
+      throw std::logic_error("embedding is frozen");
+    }
+  }
+
+  void FixDimension(size_t d) {
+    if (d == 0 || (dimension != 0 && d != dimension)) {
+      throw std::runtime_error(
+          "vector dimension mismatch: expected " +
+          std::to_string(dimension) + ", got " + std::to_string(d));
+    }
+    if (dimension == 0) {
+      dimension = d;
+      dot = utils::SelectDotKernel(dimension);
+    }
   }
 
   std::string GetTermStream() const {
@@ -151,26 +530,47 @@ private:
   }
 
   void InitWordEmbedding(std::string term) {
-    WordEmbedding wm;
-    for (size_t j = 0; j < VectorDim; ++j) {
-      wm[j] = 0.0;
-    }
-    words.insert({term, std::make_tuple(wm, 1)});
+    const auto row = words.size();
+    vectors.resize((row + 1) * dimension, 0.0);
+    norms.emplace_back(0.0);
+    words.insert({term, TermEntry(row, 1, 0.0)});
   }
 
-  bool IsStopWord(const WordEmbedding &d) const {
-    // if d is zero-vector, reguard this term as stop-word
-    for (size_t i = 0; i < VectorDim; ++i) {
-      if (d[i] != 0.0)
-        return false;
-    }
-    return true;
+  bool IsStopWord(size_t row) const {
+    // if vector is zero, reguard this term as stop-word
+    return norms[row] == 0.0;
   }
 
+  VectorTransport transport = VectorTransport::BINARY;
   std::shared_ptr<Frequency<LangType>> frequency;
+  std::shared_ptr<const ICTable> ic_table;
   unsigned int termLength;
-  std::unordered_map<std::string, std::tuple<WordEmbedding, unsigned int>>
-      words;
+  std::unordered_map<std::string, TermEntry> words;
+
+  /// <summary>
+  /// word vectors, one row of dimension values per term
+  /// </summary>
+  std::vector<double> vectors;
+
+  /// <summary>
+  /// Euclidean norm of each row, 0 for stop words
+  /// </summary>
+  std::vector<double> norms;
+
+  /// <summary>
+  /// vector of each row in vocabulary, empty with own storage
+  /// </summary>
+  std::vector<const double *> rows;
+
+  /// <summary>
+  /// keeps vectors pointed to by rows alive, null with own storage
+  /// </summary>
+  std::shared_ptr<SharedVocabulary> vocabulary;
+
+  bool frozen = false;
+  size_t dimension = VectorDim;
+  utils::DotKernel dot = utils::SelectDotKernel(VectorDim);
+  SegmentationStats stats;
 };
 } // namespace GraphSeg
 
@@ -0,0 +1,329 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_GRAPH_BIT_GRAPH_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_GRAPH_BIT_GRAPH_HPP
+
+#include "graphseg/graph/segment_graph.hpp"
+#include "graphseg/graph/undirected_graph.hpp"
+#include "graphseg/internal/segmentation_stats.hpp"
+#include "graphseg/internal/utils/bit_mask.hpp"
+#include "graphseg/internal/utils/deadline.hpp"
+#include "graphseg/internal/utils/trace.hpp"
+#include "graphseg/language.hpp"
+
+#include <algorithm>
+#include <array>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace GraphSeg::graph {
+/// <summary>
+/// Graph of documents with at most 64 Words sentences, in place of
+/// UndirectedGraph. Neighbors of a vertex are a BitMask, so Bron-Kerbosch
+/// intersects candidates with a few word operations and keeps its sets on
+/// the stack. Finds the same maximal cliques, but searches them with a
+/// pivot (Tomita): one call per clique instead of one per vertex order.
+/// Cliques are kept in the order of UndirectedGraph::GetMaximumClique(),
+/// which internal::Segmentable depends on. Edge weights are not kept
+/// </summary>
+template <Lang LangType = Lang::EN, size_t Words = 1>
+class BitGraph : public SegmentGraph<BitGraph<LangType, Words>, LangType> {
+public:
+  using Vertex = unsigned int;
+  using Mask = internal::utils::BitMask<Words>;
+  using Base = SegmentGraph<BitGraph<LangType, Words>, LangType>;
+
+  /// <summary>
+  /// largest document
+  /// </summary>
+  static constexpr size_t CAPACITY = Mask::BITS;
+
+  /// <summary>
+  /// cliques are allocated from resource, which must outlive the graph.
+  /// throws std::length_error for more than CAPACITY sentences
+  /// </summary>
+  explicit BitGraph(
+      const std::vector<typename Base::SentenceType> &_sentences,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : Base(_sentences), max_cliques(resource),
+        graph_size(CheckSize(_sentences.size())) {}
+
+  explicit BitGraph(
+      std::vector<typename Base::SentenceType> &&_sentences,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : Base(std::move(_sentences)), max_cliques(resource),
+        graph_size(CheckSize(this->sentences.size())) {}
+
+  /// <summary>
+  /// Add node to segment graph
+  /// </summary>
+  void SetNode() {
+    graph.fill(Mask());
+    touched = Mask();
+    GRAPHSEG_STATS_ONLY(stats.edges = 0;)
+  }
+
+  /// <summary>
+  /// pass edges to nodes
+  /// </summary>
+  void SetEdge(int src, int dst, double) {
+    assert(static_cast<Vertex>(src) < graph_size &&
+           static_cast<Vertex>(dst) < graph_size && src != dst);
+    graph[src].Set(dst);
+    graph[dst].Set(src);
+    touched.Set(src);
+    touched.Set(dst);
+    GRAPHSEG_STATS_ONLY(++stats.edges;)
+  }
+
+  /// <summary>
+  /// get graph size
+  /// </summary>
+  GRAPHSEG_INLINE_CONST Vertex &GetGraphSize() const & { return graph_size; }
+
+  inline Vertex GetGraphSize() && { return graph_size; }
+
+  /// <summary>
+  /// select clique search of SetMaximumClique and UpdateMaximumClique
+  /// </summary>
+  inline void SetCliqueMode(CliqueMode mode) noexcept { clique_mode = mode; }
+
+  inline CliqueMode GetCliqueMode() const noexcept {
+    return clique_mode;
+  }
+
+  /// <summary>
+  /// exact clique search stops once deadline passed, and cliques found so
+  /// far are completed by GREEDY search (see IsDegraded)
+  /// </summary>
+  inline void SetDeadline(const internal::utils::Deadline &d) noexcept {
+    deadline = d;
+    degraded = false;
+  }
+
+  /// <summary>
+  /// whether clique search was cut short by the deadline
+  /// </summary>
+  inline bool IsDegraded() const noexcept { return degraded; }
+
+  /// <summary>
+  /// calculate maximum clique
+  /// </summary>
+  void SetMaximumClique() {
+    GRAPHSEG_TRACE_SCOPE("BitGraph::SetMaximumClique");
+    GRAPHSEG_STATS_PHASE(stats, SegmentationPhase::CLIQUE);
+    GRAPHSEG_STATS_ONLY(stats.clique_search_calls = 0;
+                        stats.clique_search_depth = 0;)
+    degraded = false;
+    max_cliques.clear();
+    touched = Mask();
+    SearchCliques(Mask::Range(0, graph_size));
+  }
+
+  /// <summary>
+  /// recalculate maximum cliques after SetEdge added edges, searching only
+  /// connected components that gained an edge (see
+  /// UndirectedGraph::UpdateMaximumClique)
+  /// </summary>
+  void UpdateMaximumClique() {
+    GRAPHSEG_TRACE_SCOPE("BitGraph::UpdateMaximumClique");
+    GRAPHSEG_STATS_PHASE(stats, SegmentationPhase::CLIQUE);
+    GRAPHSEG_STATS_ONLY(stats.clique_search_calls = 0;
+                        stats.clique_search_depth = 0;)
+    // grow touched vertices to their components, a frontier at a time
+    auto dirty = touched;
+    for (auto frontier = touched; frontier.Any();) {
+      Mask next;
+      frontier.ForEach([&](size_t v) { next |= graph[v]; });
+      frontier = next & ~dirty;
+      dirty |= frontier;
+    }
+    touched = Mask();
+    if (!dirty.Any()) {
+      return;
+    }
+    max_cliques.erase(std::remove_if(max_cliques.begin(), max_cliques.end(),
+                                     [&](const Mask &clique) {
+                                       return dirty.Test(clique.Lowest());
+                                     }),
+                      max_cliques.end());
+    SearchCliques(dirty);
+  }
+
+  /// <summary>
+  /// all of maximum cliques, sorted as sets of vertices
+  /// </summary>
+  GRAPHSEG_INLINE_CONST std::pmr::vector<Mask> &GetMaximumClique() const & {
+    return max_cliques;
+  }
+
+  /// <summary>
+  /// union of the maximum cliques that include idx
+  /// </summary>
+  GRAPHSEG_INLINE_CONST Mask &GetCliqueNeighbors(size_t idx) const & {
+    return clique_neighbors[idx];
+  }
+
+  /// <summary>
+  /// adjacent nodes
+  /// </summary>
+  GRAPHSEG_INLINE_CONST Mask &operator[](size_t idx) const & {
+    return graph[idx];
+  }
+
+  /// <summary>
+  /// edges, cliques and clique search effort (GRAPHSEG_STATS only)
+  /// </summary>
+  GRAPHSEG_INLINE_CONST SegmentationStats &GetStats() const & {
+    return stats;
+  }
+
+private:
+  static Vertex CheckSize(size_t size) {
+    if (size > CAPACITY) {
+      throw std::length_error("BitGraph holds at most " +
+                              std::to_string(CAPACITY) + " sentences");
+    }
+    return static_cast<Vertex>(size);
+  }
+
+  /// <summary>
+  /// add maximal cliques among candidates, which must be a union of
+  /// connected components, by clique_mode
+  /// </summary>
+  void SearchCliques(const Mask &candidates) {
+    if (clique_mode == CliqueMode::GREEDY) {
+      GreedyCliqueCover(candidates);
+    } else {
+      BronKerbosch(Mask(), candidates, Mask());
+      if (degraded) {
+        // maximal cliques found in time are kept, greedy ones cover the rest
+        GreedyCliqueCover(candidates);
+      }
+    }
+    FinishMaximumClique();
+  }
+
+  /// <summary>
+  /// see UndirectedGraph::GreedyCliqueCover. neighbors nearest in sentence
+  /// order are tried by distance from the seed, the lower one first
+  /// </summary>
+  void GreedyCliqueCover(const Mask &seeds) {
+    seeds.ForEach([&](size_t seed) {
+      GRAPHSEG_STATS_ONLY(++stats.clique_search_calls;)
+      Mask clique;
+      clique.Set(seed);
+      // adjacent to every member added so far
+      auto common = graph[seed];
+      for (size_t d = 1; common.Any(); ++d) {
+        for (const auto u : {seed - d, seed + d}) {
+          // seed - d wraps around below 0 and is out of range then
+          if (u < graph_size && common.Test(u)) {
+            clique.Set(u);
+            common &= graph[u];
+          }
+        }
+      }
+      GRAPHSEG_STATS_ONLY(stats.clique_search_depth = std::max(
+                              stats.clique_search_depth, clique.Count());)
+      max_cliques.emplace_back(clique);
+    });
+  }
+
+  /// <summary>
+  /// sets are passed by value, a few words each
+  /// </summary>
+  void BronKerbosch(const Mask &clique, Mask candidates, Mask excluded) {
+    GRAPHSEG_STATS_ONLY(++stats.clique_search_calls;
+                        stats.clique_search_depth = std::max(
+                            stats.clique_search_depth, clique.Count());)
+    if (deadline.Expired()) {
+      degraded = true;
+      return;
+    }
+    if (!candidates.Any()) {
+      if (!excluded.Any()) {
+        max_cliques.emplace_back(clique);
+      }
+      return;
+    }
+
+    // a maximal clique includes the pivot or one of its non-neighbors, so
+    // the pivot with most neighbors among candidates leaves fewest branches
+    size_t pivot = 0, best = 0;
+    (candidates | excluded).ForEach([&](size_t u) {
+      const auto count = (candidates & graph[u]).Count();
+      if (count >= best) {
+        pivot = u;
+        best = count;
+      }
+    });
+    auto branches = candidates & ~graph[pivot];
+    while (branches.Any() && !degraded) {
+      const auto v = branches.Lowest();
+      branches.Reset(v);
+      auto clique_t = clique;
+      clique_t.Set(v);
+      BronKerbosch(clique_t, candidates & graph[v], excluded & graph[v]);
+      candidates.Reset(v);
+      excluded.Set(v);
+    }
+  }
+
+  void FinishMaximumClique() {
+    // same order and no duplicates as the std::set of UndirectedGraph
+    std::sort(max_cliques.begin(), max_cliques.end());
+    max_cliques.erase(std::unique(max_cliques.begin(), max_cliques.end()),
+                      max_cliques.end());
+    clique_neighbors.fill(Mask());
+    for (const auto &clique : max_cliques) {
+      clique.ForEach([&](size_t v) { clique_neighbors[v] |= clique; });
+    }
+#ifdef GRAPHSEG_STATS
+    stats.cliques = max_cliques.size();
+    stats.max_clique_size = 0;
+    for (const auto &clique : max_cliques) {
+      stats.max_clique_size = std::max(stats.max_clique_size, clique.Count());
+    }
+#endif
+  }
+
+  /// <summary>
+  /// neighbors of each vertex
+  /// </summary>
+  std::array<Mask, CAPACITY> graph{};
+
+  /// <summary>
+  /// maximum cliques, sorted
+  /// </summary>
+  std::pmr::vector<Mask> max_cliques;
+
+  /// <summary>
+  /// union of maximum cliques including each vertex
+  /// </summary>
+  std::array<Mask, CAPACITY> clique_neighbors{};
+
+  /// <summary>
+  /// vertices that got an edge since cliques were last calculated
+  /// </summary>
+  Mask touched;
+
+  Vertex graph_size = 0;
+
+  CliqueMode clique_mode = CliqueMode::EXACT;
+
+  internal::utils::Deadline deadline;
+  bool degraded = false;
+
+  SegmentationStats stats;
+};
+
+/// <summary>
+/// BitGraph of the fewest words holding size sentences, 0 if none does
+/// </summary>
+inline constexpr size_t BitGraphWords(size_t size) noexcept {
+  return size <= 64 ? 1 : size <= 128 ? 2 : 0;
+}
+} // namespace GraphSeg::graph
+
+#endif
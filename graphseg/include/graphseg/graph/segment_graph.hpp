@@ -31,6 +31,13 @@ public:
     return sentences[idx];
   }
 
+  /// <summary>
+  /// get all of sentences
+  /// </summary>
+  GRAPHSEG_INLINE_CONST std::vector<SentenceType> &GetSentences() const & {
+    return sentences;
+  }
+
 protected:
   SegmentGraph(const std::vector<SentenceType> &_sentences)
       : sentences(_sentences) {}
@@ -2,13 +2,18 @@
 #define GRAPHSEG_CPP_GRAPHSEG_GRAPH_UNDIRECTED_GRAPH_HPP
 
 #include "graphseg/graph/segment_graph.hpp"
+#include "graphseg/internal/segmentation_stats.hpp"
 #include "graphseg/internal/utils/custom_operator.hpp"
+#include "graphseg/internal/utils/deadline.hpp"
 #include "graphseg/internal/utils/nameof.hpp"
+#include "graphseg/internal/utils/trace.hpp"
 #include "graphseg/language.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <iterator>
 #include <memory>
+#include <memory_resource>
 #include <ostream>
 #include <set>
 #include <string>
@@ -17,6 +22,17 @@
 namespace GraphSeg::graph {
 using namespace GraphSeg::internal::utils;
 
+/// <summary>
+/// How maximal cliques are searched.
+/// EXACT: every maximal clique (Bron-Kerbosch), exponential in the worst
+/// case.
+/// GREEDY: one maximal clique per vertex, grown from it by adding
+/// neighbors nearest in sentence order first. A subset of the EXACT
+/// cliques that still covers every vertex, in O(|V| ω Δ) (ω: clique size,
+/// Δ: degree), for documents where enumeration does not finish in time
+/// </summary>
+enum class CliqueMode { EXACT, GREEDY };
+
 /// <summary>
 /// Undirected graph based on passed sentences
 /// </summary>
@@ -25,31 +41,47 @@ class UndirectedGraph
     : public SegmentGraph<UndirectedGraph<LangType>, LangType> {
 public:
   using Vertex = unsigned int;
-  using VertexSet = std::set<Vertex>;
+  using VertexSet = std::pmr::set<Vertex>;
   using Edge = std::pair<Vertex, double>;
+  using EdgeList = std::pmr::vector<Edge>;
+  using Clique = std::pmr::vector<Vertex>;
   using Base = SegmentGraph<UndirectedGraph<LangType>, LangType>;
 
   explicit UndirectedGraph() = default;
 
+  /// <summary>
+  /// adjacency lists, clique sets and Bron-Kerbosch temporaries are
+  /// allocated from resource, which must outlive the graph
+  /// </summary>
   explicit UndirectedGraph(
-      const std::vector<typename Base::SentenceType> &_sentences)
-      : Base(_sentences), graph_size(_sentences.size()) {
-    graph.resize(graph_size * graph_size);
+      const std::vector<typename Base::SentenceType> &_sentences,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : Base(_sentences), graph(resource), max_cliques_set(resource),
+        max_cliques_internal(resource), touched(resource),
+        graph_size(_sentences.size()) {
+    graph.resize(graph_size);
+    touched.resize(graph_size);
   }
 
   explicit UndirectedGraph(
-      std::vector<typename Base::SentenceType> &&_sentences)
-      : Base(std::move(_sentences)), graph_size(_sentences.size()) {
-    graph.resize(graph_size * graph_size);
+      std::vector<typename Base::SentenceType> &&_sentences,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : Base(std::move(_sentences)), graph(resource),
+        max_cliques_set(resource), max_cliques_internal(resource),
+        touched(resource),
+        graph_size(static_cast<Vertex>(this->sentences.size())) {
+    graph.resize(graph_size);
+    touched.resize(graph_size);
   }
 
   /// <summary>
   /// Add node to segment graph
   /// </summary>
   void SetNode() {
-    for (size_t i = 0; i < graph_size; ++i) {
-      graph.emplace_back(std::vector<Edge>());
-    }
+    graph.clear();
+    graph.resize(graph_size);
+    touched.assign(graph_size, false);
+    GRAPHSEG_STATS_ONLY(stats.edges = 0;)
   }
 
   /// <summary>
@@ -59,6 +91,9 @@ public:
     assert(src < graph_size && dst < graph_size);
     SetArc(src, dst, score);
     SetArc(dst, src, score);
+    touched[src] = true;
+    touched[dst] = true;
+    GRAPHSEG_STATS_ONLY(++stats.edges;)
   }
 
   /// <summary>
@@ -70,40 +105,109 @@ public:
     return std::move(graph_size);
   }
 
+  /// <summary>
+  /// select clique search of SetMaximumClique and UpdateMaximumClique
+  /// </summary>
+  inline void SetCliqueMode(CliqueMode mode) noexcept { clique_mode = mode; }
+
+  inline CliqueMode GetCliqueMode() const noexcept {
+    return clique_mode;
+  }
+
+  /// <summary>
+  /// exact clique search stops once deadline passed, and cliques found so
+  /// far are completed by GREEDY search (see IsDegraded)
+  /// </summary>
+  inline void SetDeadline(const internal::utils::Deadline &d) noexcept {
+    deadline = d;
+    degraded = false;
+  }
+
+  /// <summary>
+  /// whether clique search was cut short by the deadline
+  /// </summary>
+  inline bool IsDegraded() const noexcept { return degraded; }
+
   /// <summary>
   /// calculate maximum clique
   /// </summary>
   void SetMaximumClique() {
-    std::vector<Vertex> tmp(graph_size);
-    int i = -1;
-    std::generate(tmp.begin(), tmp.end(), [&i]() {
-      ++i;
-      return i;
-    });
-    BronKerbosch(std::set<Vertex>(), std::set<Vertex>(tmp.begin(), tmp.end()),
-                 std::set<Vertex>());
-    ConstructMaximumCliqueArrayContainer();
-#ifdef DEBUG
-    std::cout << "===== Retrieved Maximum Cliques =====" << std::endl;
-    std::cout << max_cliques_set << std::endl;
-#endif
+    GRAPHSEG_TRACE_SCOPE("UndirectedGraph::SetMaximumClique");
+    GRAPHSEG_STATS_PHASE(stats, SegmentationPhase::CLIQUE);
+    GRAPHSEG_STATS_ONLY(stats.clique_search_calls = 0;
+                        stats.clique_search_depth = 0;)
+    degraded = false;
+    max_cliques_set.clear();
+    VertexSet candidates(Resource());
+    for (Vertex v = 0; v < graph_size; ++v) {
+      candidates.emplace_hint(candidates.end(), v);
+    }
+    std::fill(touched.begin(), touched.end(), false);
+    SearchCliques(std::move(candidates));
+  }
+
+  /// <summary>
+  /// recalculate maximum cliques after SetEdge added edges to a graph whose
+  /// cliques are known (SetMaximumClique ran once). a clique lies within
+  /// one connected component, so cliques of components that gained no edge
+  /// are kept and only the touched components are searched again
+  /// </summary>
+  void UpdateMaximumClique() {
+    GRAPHSEG_TRACE_SCOPE("UndirectedGraph::UpdateMaximumClique");
+    GRAPHSEG_STATS_PHASE(stats, SegmentationPhase::CLIQUE);
+    GRAPHSEG_STATS_ONLY(stats.clique_search_calls = 0;
+                        stats.clique_search_depth = 0;)
+    std::pmr::vector<bool> dirty(graph_size, false, Resource());
+    std::pmr::vector<Vertex> stack(Resource());
+    VertexSet candidates(Resource());
+    for (Vertex v = 0; v < graph_size; ++v) {
+      if (!touched[v] || dirty[v]) {
+        continue;
+      }
+      dirty[v] = true;
+      stack.emplace_back(v);
+      while (!stack.empty()) {
+        const auto u = stack.back();
+        stack.pop_back();
+        candidates.emplace(u);
+        for (const auto &[adjacent, weight] : graph[u]) {
+          if (!dirty[adjacent]) {
+            dirty[adjacent] = true;
+            stack.emplace_back(adjacent);
+          }
+        }
+      }
+    }
+    std::fill(touched.begin(), touched.end(), false);
+    if (candidates.empty()) {
+      return;
+    }
+
+    for (auto itr = max_cliques_set.begin(); itr != max_cliques_set.end();) {
+      if (dirty[*itr->begin()]) {
+        itr = max_cliques_set.erase(itr);
+      } else {
+        ++itr;
+      }
+    }
+    SearchCliques(std::move(candidates));
   }
 
   /// <summary>
   /// get caluclated all of maximum cliques
   /// </summary>
-  GRAPHSEG_INLINE_CONST std::set<VertexSet> &GetMaximumClique() const & {
+  GRAPHSEG_INLINE_CONST std::pmr::set<VertexSet> &GetMaximumClique() const & {
     return max_cliques_set;
   }
 
-  GRAPHSEG_INLINE_CONST std::set<VertexSet> GetMaximumClique() && {
+  GRAPHSEG_INLINE_CONST std::pmr::set<VertexSet> GetMaximumClique() && {
     return std::move(max_cliques_set);
   }
 
   /// <summary>
   /// get caluclated maximum clique from internal efficient data structure
   /// </summary>
-  GRAPHSEG_INLINE_CONST std::vector<std::vector<Vertex>> &
+  GRAPHSEG_INLINE_CONST std::pmr::vector<Clique> &
   GetMaximumClique(size_t idx) {
     return max_cliques_internal[idx];
   }
@@ -111,10 +215,17 @@ public:
   /// <summary>
   /// get node number and weight that passed adjacent nodes
   /// </summary>
-  GRAPHSEG_INLINE_CONST std::vector<Edge> &operator[](size_t idx) const & {
+  GRAPHSEG_INLINE_CONST EdgeList &operator[](size_t idx) const & {
     return graph[idx];
   }
 
+  /// <summary>
+  /// edges, cliques and clique search effort (GRAPHSEG_STATS only)
+  /// </summary>
+  GRAPHSEG_INLINE_CONST SegmentationStats &GetStats() const & {
+    return stats;
+  }
+
   VertexSet GetAdjacentNodes(const size_t idx) {
     VertexSet adjacents;
     for (const auto &[adjacent_node_id, edge_weight] : graph[idx]) {
@@ -129,8 +240,91 @@ private:
     graph[src].emplace_back(pair);
   }
 
-  void BronKerbosch(std::set<Vertex> clique, std::set<Vertex> candidates,
-                    std::set<Vertex> excluded) {
+  std::pmr::memory_resource *Resource() const {
+    return graph.get_allocator().resource();
+  }
+
+  /// <summary>
+  /// add maximal cliques among candidates, which must be a union of
+  /// connected components, by clique_mode
+  /// </summary>
+  void SearchCliques(VertexSet candidates) {
+    if (clique_mode == CliqueMode::GREEDY) {
+      GreedyCliqueCover(candidates);
+    } else if (!deadline.IsSet()) {
+      BronKerbosch(VertexSet(Resource()), std::move(candidates),
+                   VertexSet(Resource()));
+    } else {
+      BronKerbosch(VertexSet(Resource()), VertexSet(candidates, Resource()),
+                   VertexSet(Resource()));
+      if (degraded) {
+        // maximal cliques found in time are kept, greedy ones cover the rest
+        GreedyCliqueCover(candidates);
+      }
+    }
+    FinishMaximumClique();
+  }
+
+  /// <summary>
+  /// For each seed, grow a clique from it: neighbors of the seed are tried
+  /// nearest in sentence order first and kept if adjacent to every member.
+  /// Every neighbor of the seed was tried, so the clique is maximal
+  /// </summary>
+  void GreedyCliqueCover(const VertexSet &seeds) {
+    // mark[u] == stamp: u is adjacent to every member added so far
+    std::pmr::vector<size_t> mark(graph_size, 0, Resource());
+    std::pmr::vector<Vertex> order(Resource());
+    size_t stamp = 0;
+    for (const auto seed : seeds) {
+      GRAPHSEG_STATS_ONLY(++stats.clique_search_calls;)
+      order.clear();
+      for (const auto &[adjacent, weight] : graph[seed]) {
+        order.emplace_back(adjacent);
+      }
+      const auto distance = [seed](Vertex v) {
+        return v > seed ? v - seed : seed - v;
+      };
+      std::sort(order.begin(), order.end(), [&](Vertex a, Vertex b) {
+        return distance(a) != distance(b) ? distance(a) < distance(b) : a < b;
+      });
+
+      VertexSet clique({seed}, Resource());
+      ++stamp;
+      for (const auto u : order) {
+        mark[u] = stamp;
+      }
+      for (const auto u : order) {
+        if (mark[u] != stamp) {
+          continue;
+        }
+        clique.emplace(u);
+        // candidates keep the mark only if they are adjacent to u as well
+        ++stamp;
+        for (const auto &[adjacent, weight] : graph[u]) {
+          if (mark[adjacent] == stamp - 1) {
+            mark[adjacent] = stamp;
+          }
+        }
+      }
+      GRAPHSEG_STATS_ONLY(stats.clique_search_depth = std::max(
+                              stats.clique_search_depth, clique.size());)
+      max_cliques_set.emplace(std::move(clique));
+    }
+  }
+
+  /// <summary>
+  /// sets are moved in, copies would fall back to default resource
+  /// </summary>
+  void BronKerbosch(VertexSet clique, VertexSet candidates,
+                    VertexSet excluded) {
+    // every recursion adds one vertex, so depth equals clique size
+    GRAPHSEG_STATS_ONLY(++stats.clique_search_calls;
+                        stats.clique_search_depth = std::max(
+                            stats.clique_search_depth, clique.size());)
+    if (deadline.Expired()) {
+      degraded = true;
+      return;
+    }
     if (candidates.empty() && excluded.empty()) {
       max_cliques_set.insert(clique);
       return;
@@ -138,38 +332,56 @@ private:
 
     // TODO(rei.shimizu): It may be invalid solution to resolve iterator
     // breakdown problem
-    std::set<Vertex> candidates_tmp;
+    VertexSet candidates_tmp(Resource());
     for (auto itr2 = candidates.begin(); itr2 != candidates.end(); ++itr2) {
       if (candidates_tmp.find(*itr2) != candidates_tmp.end())
         break;
       auto v = *itr2;
-      auto clique_t = clique + std::set<Vertex>({v});
-      auto candidates_t = candidates & GetNeighbors(v);
-      auto excluded_t = excluded & GetNeighbors(v);
+      auto clique_t = clique + VertexSet({v}, Resource());
+      const auto neighbors = GetNeighbors(v);
+      auto candidates_t = candidates & neighbors;
+      auto excluded_t = excluded & neighbors;
 
       assert(clique_t.size() > clique.size());
       assert(candidates_t.size() <= candidates.size());
       assert(excluded_t.size() <= excluded.size());
 
-      BronKerbosch(clique_t, candidates_t, excluded_t);
+      BronKerbosch(std::move(clique_t), std::move(candidates_t),
+                   std::move(excluded_t));
 
       candidates_tmp.insert(v);
       excluded.insert(v);
     }
   }
 
+  void FinishMaximumClique() {
+    ConstructMaximumCliqueArrayContainer();
+#ifdef GRAPHSEG_STATS
+    stats.cliques = max_cliques_set.size();
+    stats.max_clique_size = 0;
+    for (const auto &clique : max_cliques_set) {
+      stats.max_clique_size = std::max(stats.max_clique_size, clique.size());
+    }
+#endif
+#ifdef DEBUG
+    std::cout << "===== Retrieved Maximum Cliques =====" << std::endl;
+    std::cout << max_cliques_set << std::endl;
+#endif
+  }
+
   void ConstructMaximumCliqueArrayContainer() {
+    max_cliques_internal.clear();
     max_cliques_internal.resize(graph_size);
     for (auto &max_clique : max_cliques_set) {
       for (auto &clique_vertex : max_clique) {
-        max_cliques_internal[clique_vertex].emplace_back(
-            std::vector<Vertex>(max_clique.begin(), max_clique.end()));
+        max_cliques_internal[clique_vertex].emplace_back(max_clique.begin(),
+                                                         max_clique.end());
       }
     }
   }
 
-  std::set<Vertex> GetNeighbors(Vertex idx) {
-    std::set<Vertex> tmp;
+  VertexSet GetNeighbors(Vertex idx) const {
+    VertexSet tmp(Resource());
     for (const auto &node : graph[idx]) {
       tmp.emplace(node.first);
     }
@@ -179,22 +391,34 @@ private:
   /// <summary>
   /// Base graph
   /// </summary>
-  std::vector<std::vector<Edge>> graph;
+  std::pmr::vector<EdgeList> graph;
 
   /// <summary>
   /// std::set of maximum clique
   /// </summary>
-  std::set<VertexSet> max_cliques_set;
+  std::pmr::set<VertexSet> max_cliques_set;
 
   /// <summary>
   /// Data structure to get maximum clique with O(N)
   /// <summary>
-  std::vector<std::vector<std::vector<Vertex>>> max_cliques_internal;
+  std::pmr::vector<std::pmr::vector<Clique>> max_cliques_internal;
+
+  /// <summary>
+  /// vertices that got an edge since cliques were last calculated
+  /// </summary>
+  std::pmr::vector<bool> touched;
 
   /// <summary>
   /// current graph size
   /// </summary>
   Vertex graph_size = 0;
+
+  CliqueMode clique_mode = CliqueMode::EXACT;
+
+  internal::utils::Deadline deadline;
+  bool degraded = false;
+
+  SegmentationStats stats;
 };
 } // namespace GraphSeg::graph
 
@@ -3,8 +3,10 @@
 
 #define GRAPHSEG_INLINE_CONST inline const
 
+#include "graphseg/document_segmenter.hpp"
 #include "graphseg/embedding.hpp"
 #include "graphseg/language.hpp"
+#include "graphseg/pipeline.hpp"
 #include "graphseg/segmentation_container.hpp"
 #include "graphseg/sentence.hpp"
 #include "graphseg/text.hpp"
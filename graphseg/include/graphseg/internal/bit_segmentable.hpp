@@ -0,0 +1,302 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_BIT_SEGMENTABLE_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_BIT_SEGMENTABLE_HPP
+
+#include "graphseg/embedding.hpp"
+#include "graphseg/graph/bit_graph.hpp"
+#include "graphseg/internal/segment_engine.hpp"
+#include "graphseg/internal/segment_state.hpp"
+#include "graphseg/internal/segmentable.hpp"
+#include "graphseg/internal/segmentation_stats.hpp"
+#include "graphseg/internal/utils/trace.hpp"
+#include "graphseg/language.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+namespace GraphSeg::internal {
+/// <summary>
+/// Segmentable of graph::BitGraph. Segments are bit ranges of sentences
+/// held in place, so the init, merge and small passes allocate nothing;
+/// segments are handed out as SegmentList once done. Passes and their
+/// order of relatedness sums are those of Segmentable, so are the segments
+/// </summary>
+template <int VectorDim, Lang LangType, size_t Words>
+class Segmentable<graph::BitGraph<LangType, Words>, VectorDim, LangType>
+    : public SegmentEngine {
+  using Graph = graph::BitGraph<LangType, Words>;
+  using Mask = typename Graph::Mask;
+
+public:
+  /// <summary>
+  /// current segment state
+  /// </summary>
+  mutable GraphSeg::SegmentStatus current_status{GraphSeg::SegmentStatus::NONE};
+
+  explicit Segmentable() = default;
+
+  /// <summary>
+  /// segments are allocated from resource
+  /// </summary>
+  explicit Segmentable(
+      std::shared_ptr<Graph> g,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : SegmentEngine(resource), graph(g) {}
+
+  /// <summary>
+  /// construct segment from maximum clique
+  /// </summary>
+  void ConstructSegment(const Embedding<VectorDim, LangType> &embedding) {
+    Construct([&](Vertex a, Vertex b) {
+      return embedding.NormalizedSimilarity(graph->GetSentence(a),
+                                            graph->GetSentence(b));
+    });
+  }
+
+  /// <summary>
+  /// construct segment, relatedness(a, b) of sentences a and b decides
+  /// where small segments are merged
+  /// </summary>
+  template <class Relatedness> void Construct(const Relatedness &relatedness) {
+    while (current_status != GraphSeg::SegmentStatus::TERMINATED) {
+      switch (current_status) {
+      case GraphSeg::SegmentStatus::NONE:
+        assert(segments.size() == 0);
+        ConstructInitSegment();
+        current_status = GraphSeg::SegmentStatus::INITIALIZED;
+        break;
+      case GraphSeg::SegmentStatus::INITIALIZED:
+        ConstructMergedSegment();
+        current_status = GraphSeg::SegmentStatus::MERGED;
+        break;
+      case GraphSeg::SegmentStatus::MERGED:
+        ConstructSmallSegment(relatedness);
+        current_status = GraphSeg::SegmentStatus::SMALLED;
+        break;
+      case GraphSeg::SegmentStatus::SMALLED:
+        ExportSegments();
+        current_status = GraphSeg::SegmentStatus::TERMINATED;
+        break;
+      default:
+        break;
+      }
+    }
+  }
+
+private:
+  /// <summary>
+  /// segments of a pass in sentence order, with checked flags of them
+  /// </summary>
+  struct BitSegments {
+    std::array<Mask, Graph::CAPACITY> ranges;
+    size_t size = 0;
+    Mask checked;
+
+    void Push(const Mask &segment) { ranges[size++] = segment; }
+
+    void MarkForward(size_t idx) {
+      checked.Set(idx);
+      checked.Set(idx + 1);
+    }
+
+    void MarkBackward(size_t idx) {
+      checked.Set(idx);
+      checked.Set(idx - 1);
+    }
+  };
+
+  /// <summary>
+  /// see Segmentable::IsMergable: some maximum clique including a sentence
+  /// of the first segment, all of them in reach, includes one of sg2
+  /// </summary>
+  static bool IsMergable(const Mask &reach, const Mask &sg2) {
+    return (reach & sg2).Any();
+  }
+
+  Mask Reach(const Mask &segment) const {
+    Mask reach;
+    segment.ForEach([&](size_t v) { reach |= graph->GetCliqueNeighbors(v); });
+    return reach;
+  }
+
+  template <class Relatedness>
+  double SegmentRelatedness(const Relatedness &relatedness, const Mask &seg1,
+                            const Mask &seg2) {
+    const auto size = seg1.Count() * seg2.Count();
+    GRAPHSEG_STATS_ONLY(stats.similarity_evaluations += size;)
+    double rel = 1.0;
+    seg1.ForEach([&](size_t sent1) {
+      seg2.ForEach([&](size_t sent2) {
+        rel += relatedness(static_cast<Vertex>(sent1),
+                           static_cast<Vertex>(sent2));
+      });
+    });
+    return rel / static_cast<double>(size);
+  }
+
+  /// <summary>
+  /// instantiate segment. a maximum clique claims its sentences not
+  /// claimed by a former one, and runs of them are segments. the runs
+  /// split [0, N) apart from sentences of no clique, so they are kept in
+  /// sentence order as they are found
+  /// </summary>
+  void ConstructInitSegment() {
+    GRAPHSEG_TRACE_SCOPE("Segmentable::ConstructInitSegment");
+    GRAPHSEG_STATS_PHASE(stats, SegmentationPhase::INIT);
+    constexpr auto unclaimed = static_cast<uint32_t>(-1);
+    std::array<uint32_t, Graph::CAPACITY> owner;
+    owner.fill(unclaimed);
+    Mask claimed;
+    uint32_t index = 0;
+    for (const auto &clique : graph->GetMaximumClique()) {
+      const auto fresh = clique & ~claimed;
+      fresh.ForEach([&](size_t v) { owner[v] = index; });
+      claimed |= fresh;
+      ++index;
+    }
+
+    current.size = 0;
+    current.checked = Mask();
+    const auto size = graph->GetGraphSize();
+    for (size_t begin = 0; begin < size;) {
+      auto end = begin + 1;
+      while (end < size && owner[end] == owner[begin]) {
+        ++end;
+      }
+      if (owner[begin] != unclaimed) {
+        current.Push(Mask::Range(begin, end));
+      }
+      begin = end;
+    }
+    GRAPHSEG_STATS_ONLY(stats.initial_segments = current.size;)
+  }
+
+  void ConstructMergedSegment() {
+    GRAPHSEG_TRACE_SCOPE("Segmentable::ConstructMergedSegment");
+    GRAPHSEG_STATS_PHASE(stats, SegmentationPhase::MERGE);
+    if (current.size == 0) {
+      return;
+    }
+    BitSegments next;
+
+    for (size_t i = 0; i < current.size - 1; ++i) {
+      if (current.checked.Test(i)) {
+        continue;
+      }
+
+      auto reach = Reach(current.ranges[i]);
+      if (IsMergable(reach, current.ranges[i + 1])) {
+        auto merged_segment = current.ranges[i] | current.ranges[i + 1];
+        reach |= Reach(current.ranges[i + 1]);
+        current.MarkForward(i);
+
+        // merge if the segment can merge ahead segments
+        for (size_t j = 2; i + j < current.size &&
+                           IsMergable(reach, current.ranges[i + j]);
+             ++j) {
+          merged_segment |= current.ranges[i + j];
+          reach |= Reach(current.ranges[i + j]);
+          current.checked.Set(i + j);
+        }
+
+        next.Push(merged_segment);
+      } else {
+        next.Push(current.ranges[i]);
+        current.checked.Set(i);
+      }
+    }
+
+    if (!current.checked.Test(current.size - 1)) {
+      next.Push(current.ranges[current.size - 1]);
+    }
+
+    GRAPHSEG_STATS_ONLY(stats.clique_merges = current.size - next.size;)
+    current = next;
+  }
+
+  /// <summary>
+  /// merge segments that don't have length higher than thereshold
+  /// </summary>
+  template <class Relatedness>
+  void ConstructSmallSegment(const Relatedness &relatedness) {
+    GRAPHSEG_TRACE_SCOPE("Segmentable::ConstructSmallSegment");
+    GRAPHSEG_STATS_PHASE(stats, SegmentationPhase::SMALL);
+    if (current.size == 0) {
+      return;
+    }
+    BitSegments next;
+
+    for (size_t i = 0; i < current.size - 1; ++i) {
+      const auto &current_segment = current.ranges[i];
+      const auto &next_segment = current.ranges[i + 1];
+
+      if (current.checked.Test(i)) {
+        continue;
+      }
+
+      if (current_segment.Count() < minimum_segment_size) {
+        if (i == 0) // first indexed segment can merge second indexed that only
+        {
+          current.MarkForward(i);
+          next.Push(current_segment | next_segment);
+        } else {
+          const auto &prev_segment = current.ranges[i - 1];
+          Mask merged_segment;
+
+          if (!current.checked.Test(i - 1) && !current.checked.Test(i + 1)) {
+            auto before = SegmentRelatedness(relatedness, current_segment,
+                                             prev_segment);
+            auto after = SegmentRelatedness(relatedness, current_segment,
+                                             next_segment);
+
+            if (before > after) {
+              merged_segment = prev_segment | current_segment;
+              current.MarkBackward(i);
+            } else {
+              merged_segment = current_segment | next_segment;
+              current.MarkForward(i);
+            }
+          } else if (!current.checked.Test(i - 1)) {
+            merged_segment = prev_segment | current_segment;
+            current.MarkBackward(i);
+          } else if (!current.checked.Test(i + 1)) {
+            merged_segment = current_segment | next_segment;
+            current.MarkForward(i);
+          }
+
+          next.Push(merged_segment);
+        }
+      } else {
+        next.Push(current_segment);
+        current.checked.Set(i);
+      }
+    }
+
+    // if the last segment was not merged
+    if (!current.checked.Test(current.size - 1)) {
+      next.Push(current.ranges[current.size - 1]);
+    }
+
+    GRAPHSEG_STATS_ONLY(stats.small_segment_merges = current.size - next.size;)
+    current = next;
+  }
+
+  void ExportSegments() {
+    segments.reserve(current.size);
+    for (size_t i = 0; i < current.size; ++i) {
+      Segment segment(Resource());
+      segment.reserve(current.ranges[i].Count());
+      current.ranges[i].ForEach(
+          [&](size_t v) { segment.emplace_back(static_cast<Vertex>(v)); });
+      segments.emplace_back(std::move(segment));
+    }
+  }
+
+  std::shared_ptr<Graph> graph;
+
+  BitSegments current;
+};
+} // namespace GraphSeg::internal
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_COHERENCE_SEGMENTABLE_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_COHERENCE_SEGMENTABLE_HPP
+
+#include "graphseg/internal/segment_engine.hpp"
+#include "graphseg/internal/segmentation_stats.hpp"
+#include "graphseg/internal/utils/deadline.hpp"
+#include "graphseg/internal/utils/trace.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <memory_resource>
+#include <vector>
+
+namespace GraphSeg::internal {
+/// <summary>
+/// Segments of consecutive sentences maximizing coherence, the sum of
+/// similarity(i, j) - threshold over sentence pairs within a segment:
+/// pairs that would be edges of the graph pull sentences together, the
+/// others push them apart. Dynamic programming over the end of the last
+/// segment with segments of at most maximum_segment_length sentences
+/// takes O(N W) similarity lookups and time whatever the graph density
+/// </summary>
+class CoherenceSegmentable : public SegmentEngine {
+public:
+  /// <summary>
+  /// longest segment W, 0 for the whole document (O(N^2)). raised to
+  /// 2 minimum_segment_size - 1 so that any document can be covered
+  /// </summary>
+  size_t maximum_segment_length = 0;
+
+  /// <summary>
+  /// once passed, remaining boundaries are chosen among segments of at most
+  /// 2 minimum_segment_size - 1 sentences
+  /// </summary>
+  utils::Deadline deadline;
+
+  explicit CoherenceSegmentable(
+      size_t _size,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : SegmentEngine(resource), size(_size) {}
+
+  /// <summary>
+  /// construct segments, similarity(i, j) is called for i < j with
+  /// j - i < maximum segment length
+  /// </summary>
+  template <class Similarity>
+  void Construct(const Similarity &similarity, double threshold) {
+    GRAPHSEG_TRACE_SCOPE("CoherenceSegmentable::Construct");
+    GRAPHSEG_STATS_PHASE(stats, SegmentationPhase::COHERENCE);
+    segments.clear();
+    if (size == 0) {
+      return;
+    }
+    const auto minimum = std::max<size_t>(minimum_segment_size, 1);
+    auto maximum = maximum_segment_length == 0 ? size : maximum_segment_length;
+    maximum = std::min(std::max(maximum, 2 * minimum - 1), size);
+
+    constexpr auto unreachable = -std::numeric_limits<double>::infinity();
+    // best[e]: coherence of sentences [0, e), from[e]: start of last segment
+    std::pmr::vector<double> best(size + 1, unreachable, Resource());
+    std::pmr::vector<size_t> from(size + 1, 0, Resource());
+    // coherence[s]: of segment [s, e) for current e, updated in place
+    std::pmr::vector<double> coherence(size, 0.0, Resource());
+    best[0] = 0.0;
+    for (size_t e = 1; e <= size; ++e) {
+      if (!degraded && deadline.Expired()) {
+        // shortest segments that still cover any length
+        maximum = std::min(maximum, 2 * minimum - 1);
+        degraded = true;
+      }
+      const auto last = e - 1;
+      const auto first = e > maximum ? e - maximum : 0;
+      // adding sentence last to [s, e - 1) adds its pairs with s..last-1
+      double added = 0.0;
+      for (size_t s = last; s-- > first;) {
+        added += similarity(s, last) - threshold;
+        coherence[s] += added;
+      }
+      coherence[last] = 0.0;
+      GRAPHSEG_STATS_ONLY(stats.similarity_evaluations += last - first;)
+
+      for (size_t s = first; s + minimum <= e; ++s) {
+        if (best[s] == unreachable) {
+          continue;
+        }
+        const auto candidate = best[s] + coherence[s];
+        if (candidate > best[e]) {
+          best[e] = candidate;
+          from[e] = s;
+        }
+      }
+    }
+
+    if (best[size] == unreachable) {
+      // fewer sentences than minimum_segment_size
+      Segment segment(Resource());
+      for (Vertex v = 0; v < size; ++v) {
+        segment.emplace_back(v);
+      }
+      segments.emplace_back(std::move(segment));
+      return;
+    }
+    std::pmr::vector<size_t> ends(Resource());
+    for (auto e = size; e > 0; e = from[e]) {
+      ends.emplace_back(e);
+    }
+    size_t begin = 0;
+    for (auto itr = ends.rbegin(); itr != ends.rend(); ++itr) {
+      Segment segment(Resource());
+      for (auto v = begin; v < *itr; ++v) {
+        segment.emplace_back(static_cast<Vertex>(v));
+      }
+      segments.emplace_back(std::move(segment));
+      begin = *itr;
+    }
+    GRAPHSEG_STATS_ONLY(stats.initial_segments = segments.size();)
+  }
+
+private:
+  /// <summary>
+  /// count of sentences
+  /// </summary>
+  size_t size;
+};
+} // namespace GraphSeg::internal
+
+#endif
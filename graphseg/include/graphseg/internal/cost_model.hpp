@@ -0,0 +1,294 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_COST_MODEL_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_COST_MODEL_HPP
+
+#include "graphseg/graph/undirected_graph.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace GraphSeg {
+/// <summary>
+/// Edge construction and clique search chosen for one document by
+/// internal::CostModel, with the estimates it was chosen from
+/// </summary>
+struct ExecutionPlan {
+  /// <summary>
+  /// pairs with j - i <= edge_band are scored, 0 for all pairs
+  /// </summary>
+  size_t edge_band = 0;
+
+  graph::CliqueMode clique_mode = graph::CliqueMode::EXACT;
+
+  /// <summary>
+  /// sentence pairs scored to estimate density, fraction of them above
+  /// threshold among near (j - i <= CostModel::window) and far pairs, and
+  /// of pairs of near neighbors of a vertex that are adjacent
+  /// </summary>
+  size_t sampled_pairs = 0;
+  double near_density = 0.0;
+  double far_density = 0.0;
+  double clustering = 0.0;
+
+  /// <summary>
+  /// estimated edges of the graph, similarity evaluations of edge
+  /// construction and clique search calls of the plan
+  /// </summary>
+  double edges = 0.0;
+  double edge_cost = 0.0;
+  double clique_cost = 0.0;
+};
+} // namespace GraphSeg
+
+namespace GraphSeg::internal {
+/// <summary>
+/// Chooses ExecutionPlan from document length and edge density estimated
+/// on a sample of sentence pairs, instead of running every document
+/// through all pairs and exact clique search.
+/// Edges are expected mostly between nearby sentences, so near and far
+/// pairs are sampled apart. All pairs are scored unless that costs more
+/// than edge_cost_limit and pairs sampled beyond a band show it keeps all
+/// but far_edge_tolerance of the expected edges.
+/// Bron-Kerbosch of graph::UndirectedGraph is called once per order of the
+/// vertices of every clique, Σ_k P(d, k) q^(k (k - 1) / 2) times from a
+/// vertex whose d neighbors are adjacent with probability q. d and q are
+/// taken around sampled vertices, and GREEDY is chosen when the calls
+/// exceed clique_cost_limit
+/// </summary>
+class CostModel {
+public:
+  /// <summary>
+  /// pairs scored to estimate density, half near and half far. about as
+  /// many more are scored around sample_size / (2 window) vertices
+  /// </summary>
+  size_t sample_size = 512;
+
+  /// <summary>
+  /// largest j - i of a near pair
+  /// </summary>
+  size_t window = 16;
+
+  /// <summary>
+  /// similarity evaluations allowed before a band is considered
+  /// </summary>
+  double edge_cost_limit = 2e6;
+
+  /// <summary>
+  /// expected fraction of edges a band may drop
+  /// </summary>
+  double far_edge_tolerance = 0.05;
+
+  /// <summary>
+  /// expected Bron-Kerbosch calls (about a microsecond each) allowed
+  /// before GREEDY is chosen
+  /// </summary>
+  double clique_cost_limit = 1e5;
+
+  /// <summary>
+  /// plan for size sentences, is_edge(i, j) for i < j tells whether the
+  /// pair scores above threshold. the sample depends on size only, so a
+  /// document is always given the same plan
+  /// </summary>
+  template <class IsEdge>
+  ExecutionPlan Choose(size_t size, const IsEdge &is_edge) const {
+    ExecutionPlan plan;
+    if (size < 2) {
+      return plan;
+    }
+    const auto n = static_cast<double>(size);
+    const auto all = Within(size, size);
+    const auto near = Within(size, window);
+    std::mt19937_64 rng(size);
+    std::uniform_int_distribution<size_t> vertex(0, size - 1);
+
+    size_t near_edges = 0, near_samples = 0, far_edges = 0, far_samples = 0;
+    const auto count = [&](size_t i, size_t j) {
+      const bool edge = is_edge(i, j);
+      if (j - i <= window) {
+        near_edges += edge;
+        ++near_samples;
+      } else {
+        far_edges += edge;
+        ++far_samples;
+      }
+    };
+    if (all <= static_cast<double>(sample_size)) {
+      for (size_t i = 0; i < size; ++i) {
+        for (size_t j = i + 1; j < size; ++j) {
+          count(i, j);
+        }
+      }
+    } else {
+      std::uniform_int_distribution<size_t> distance(
+          1, std::min(window, size - 1));
+      for (size_t k = 0; k < sample_size / 2; ++k) {
+        const auto d = distance(rng);
+        const auto i = std::uniform_int_distribution<size_t>(
+            0, size - 1 - d)(rng);
+        count(i, i + d);
+      }
+      // rejection keeps far pairs uniform, give up on documents with few
+      const auto far = sample_size - sample_size / 2;
+      for (size_t tries = 0; far_samples < far && tries < 4 * far; ++tries) {
+        auto i = vertex(rng), j = vertex(rng);
+        if (i > j) {
+          std::swap(i, j);
+        }
+        if (j - i > window) {
+          count(i, j);
+        }
+      }
+    }
+    plan.sampled_pairs = near_samples + far_samples;
+    plan.near_density = Ratio(near_edges, near_samples);
+    plan.far_density = Ratio(far_edges, far_samples);
+
+    const auto edges =
+        plan.near_density * near + plan.far_density * (all - near);
+    plan.edges = edges;
+    plan.edge_cost = all;
+    const auto band =
+        std::max(window, static_cast<size_t>(edge_cost_limit / n));
+    if (all > edge_cost_limit && band < size - 1) {
+      const auto kept = Within(size, band);
+      const auto beyond = all - kept;
+      // enough pairs beyond band that one edge among them stands for less
+      // than the tolerance, capped to a fraction of the evaluations saved
+      const auto needed = static_cast<size_t>(std::ceil(
+          std::min(beyond / std::max(far_edge_tolerance * edges, 1.0),
+                   edge_cost_limit / 8.0)));
+      size_t hits = 0, samples = 0;
+      for (size_t tries = 0; samples < needed && tries < 4 * needed;
+           ++tries) {
+        auto i = vertex(rng), j = vertex(rng);
+        if (i > j) {
+          std::swap(i, j);
+        }
+        if (j - i > band) {
+          hits += is_edge(i, j);
+          ++samples;
+        }
+      }
+      plan.sampled_pairs += samples;
+      // one more edge than found, so that finding none is not enough
+      // unless the sample is large
+      const auto dropped = samples != 0 ? static_cast<double>(hits + 1) *
+                                              beyond /
+                                              static_cast<double>(samples)
+                                        : beyond;
+      if (dropped <= far_edge_tolerance * edges) {
+        plan.edge_band = band;
+        plan.edge_cost = kept;
+        plan.edges = plan.near_density * near +
+                     plan.far_density * (kept - near);
+      }
+    }
+    const auto reach = plan.edge_band == 0 ? size : plan.edge_band;
+
+    // calls grow factorially with the densest neighborhoods, which mean
+    // degree hides, so they are averaged over sampled vertices
+    const auto vertices = std::max<size_t>(sample_size / (2 * window), 1);
+    std::vector<size_t> neighbors;
+    double calls = 0.0, clustering = 0.0, clique_size = 1.0;
+    size_t clustered = 0;
+    for (size_t k = 0; k < vertices; ++k) {
+      const auto v = vertex(rng);
+      const auto first = v > window ? v - window : 0;
+      const auto last = std::min(size - 1, v + window);
+      neighbors.clear();
+      for (auto u = first; u <= last; ++u) {
+        if (u != v && is_edge(std::min(u, v), std::max(u, v))) {
+          neighbors.emplace_back(u);
+        }
+      }
+      const auto near_neighbors = neighbors.size();
+      // as many far partners within reach, found ones stand for the rest
+      const auto far = static_cast<double>(
+          std::min(size - 1, v + reach) - (v > reach ? v - reach : 0) -
+          (last - first));
+      size_t far_tries = 0;
+      for (size_t t = 0; far > 0.0 && t < 2 * window; ++t) {
+        const auto u = vertex(rng);
+        const auto d = u > v ? u - v : v - u;
+        if (d > window && d <= reach) {
+          ++far_tries;
+          if (is_edge(std::min(u, v), std::max(u, v))) {
+            neighbors.emplace_back(u);
+          }
+        }
+      }
+      // pairs among near neighbors, at most 2 window of them
+      size_t pairs = 0, adjacent = 0;
+      for (size_t a = 0; a < neighbors.size() && pairs < 2 * window; ++a) {
+        for (size_t b = a + 1; b < neighbors.size() && pairs < 2 * window;
+             ++b) {
+          ++pairs;
+          adjacent += is_edge(neighbors[a], neighbors[b]);
+        }
+      }
+      plan.sampled_pairs += last - first + far_tries + pairs;
+      const auto q = pairs != 0 ? Ratio(adjacent, pairs) : plan.near_density;
+      if (pairs != 0) {
+        clustering += q;
+        ++clustered;
+      }
+      const auto degree =
+          static_cast<double>(near_neighbors) +
+          far * Ratio(neighbors.size() - near_neighbors, far_tries);
+      const auto [vertex_calls, vertex_clique] = CallsPerVertex(degree, q);
+      calls += vertex_calls;
+      clique_size = std::max(clique_size, vertex_clique);
+    }
+    plan.clustering =
+        clustered != 0 ? clustering / static_cast<double>(clustered)
+                       : plan.near_density;
+    plan.clique_cost = n * calls / static_cast<double>(vertices);
+    if (plan.clique_cost > clique_cost_limit) {
+      plan.clique_mode = graph::CliqueMode::GREEDY;
+      // every vertex tries each neighbor against members of its clique
+      plan.clique_cost = n * (1.0 + 2.0 * plan.edges / n) * clique_size;
+    }
+    return plan;
+  }
+
+private:
+  /// <summary>
+  /// count of pairs with j - i <= band among size sentences
+  /// </summary>
+  static double Within(size_t size, size_t band) noexcept {
+    const auto n = static_cast<double>(size);
+    const auto w = static_cast<double>(std::min(band, size - 1));
+    return n * w - w * (w + 1.0) / 2.0;
+  }
+
+  static double Ratio(size_t a, size_t b) noexcept {
+    return b == 0 ? 0.0 : static_cast<double>(a) / static_cast<double>(b);
+  }
+
+  /// <summary>
+  /// expected ordered cliques starting from a vertex with d neighbors,
+  /// pairwise adjacent with probability q, and size of the largest clique
+  /// expected to exist there
+  /// </summary>
+  static std::pair<double, double> CallsPerVertex(double d, double q) {
+    double calls = 1.0, clique_size = 1.0;
+    const auto log_q = q > 0.0 ? std::log(q) : -HUGE_VAL;
+    for (double k = 1.0; k <= d; k += 1.0) {
+      const auto log_pairs = k > 1.0 ? k * (k - 1.0) / 2.0 * log_q : 0.0;
+      const auto log_ordered =
+          std::lgamma(d + 1.0) - std::lgamma(d - k + 1.0) + log_pairs;
+      calls += std::exp(log_ordered);
+      if (log_ordered - std::lgamma(k + 1.0) >= 0.0) {
+        clique_size = k + 1.0;
+      }
+    }
+    return {calls, clique_size};
+  }
+};
+} // namespace GraphSeg::internal
+
+#endif
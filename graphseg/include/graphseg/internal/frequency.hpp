@@ -3,85 +3,141 @@
 
 #include "graphseg/language.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
-#include <rapidjson/document.h>
+#include <rapidjson/reader.h>
 #include <string>
 #include <type_traits>
-#include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace GraphSeg::internal {
 using namespace rapidjson;
 
+/// <summary>
+/// Corpus counts of terms from frequency.py. Counts are kept in a flat
+/// array sorted by term and never change after construction, so queries
+/// are read-only and safe from any number of threads
+/// </summary>
 template <Lang LangType = Lang::EN>
 class Frequency : public Executable<LangType> {
   using Base = Executable<LangType>;
 
 public:
-  explicit Frequency(const std::string &stream) { AddFrequency(stream); }
+  explicit Frequency(const std::string &stream) {
+    AddFrequency(stream);
+    Freeze();
+  }
 
-  explicit Frequency(std::string &&stream) { AddFrequency(std::move(stream)); }
+  explicit Frequency(std::string &&stream) {
+    AddFrequency(std::move(stream));
+    Freeze();
+  }
 
   /// <summary>
   /// get term frequency ratio
   /// </summary>
-  GRAPHSEG_INLINE_CONST unsigned int GetFrequency(const std::string &term) {
-    return frequency_count[term];
+  GRAPHSEG_INLINE_CONST unsigned int
+  GetFrequency(const std::string &term) const {
+    const auto itr =
+        std::lower_bound(frequency_count.begin(), frequency_count.end(), term,
+                         [](const auto &entry, const std::string &t) {
+                           return entry.first < t;
+                         });
+    if (itr == frequency_count.end() || itr->first != term) {
+      return 0;
+    }
+    return itr->second;
   }
 
   /// <summary>
   /// number of terms
   /// </summary>
-  GRAPHSEG_INLINE_CONST unsigned int &GetTotalCount() noexcept {
+  GRAPHSEG_INLINE_CONST unsigned int &GetTotalCount() const noexcept {
     return total_count;
   }
 
   /// <summary>
   /// get corpus size
   /// </summary>
-  GRAPHSEG_INLINE_CONST unsigned int &GetCorpusSize() noexcept {
+  GRAPHSEG_INLINE_CONST unsigned int &GetCorpusSize() const noexcept {
     return corpus_size;
   }
 
 private:
+  /// <summary>
+  /// SAX handler for frequency.py output
+  /// </summary>
+  class FrequencyHandler
+      : public BaseReaderHandler<UTF8<>, FrequencyHandler> {
+  public:
+    explicit FrequencyHandler(Frequency &_frequency) : frequency(_frequency) {}
+
+    bool Key(const char *str, SizeType length, bool) {
+      key.assign(str, length);
+      return true;
+    }
+
+    bool Uint(unsigned count) {
+      if (key == "corpus_size") {
+        frequency.corpus_size = count;
+      } else if (key == "total_count") {
+        frequency.total_count = count;
+      } else {
+        frequency.frequency_count.emplace_back(key, count);
+      }
+      return true;
+    }
+
+    bool Uint64(uint64_t count) { return Uint(static_cast<unsigned>(count)); }
+
+  private:
+    Frequency &frequency;
+    std::string key;
+  };
+
   template <typename T,
             std::enable_if_t<std::is_same_v<std::string, std::decay_t<T>>> * =
                 nullptr>
   void AddFrequency(T &&stream) {
-    auto result = Base::Execute("frequency.py", std::forward<T>(stream));
-    Document doc;
-    const auto parse_result = doc.Parse(result.c_str()).HasParseError();
-    assert(parse_result == false);
-    for (auto itr = doc.MemberBegin(); itr != doc.MemberEnd(); ++itr) {
-      const auto &term = itr->name.GetString();
-      assert(doc.HasMember(term));
-      if (std::string(term) == "corpus_size") {
-        corpus_size = doc[term].GetUint();
-        continue;
-      }
-      if (std::string(term) == "total_count") {
-        total_count = doc[term].GetUint();
-        continue;
+    FrequencyHandler handler(*this);
+    Base::Execute("frequency.py", std::forward<T>(stream), handler);
+  }
+
+  /// <summary>
+  /// sort counts for binary search, a repeated term keeps its last count
+  /// </summary>
+  void Freeze() {
+    std::stable_sort(
+        frequency_count.begin(), frequency_count.end(),
+        [](const auto &a, const auto &b) { return a.first < b.first; });
+    std::vector<std::pair<std::string, unsigned int>> unique;
+    unique.reserve(frequency_count.size());
+    for (auto &entry : frequency_count) {
+      if (!unique.empty() && unique.back().first == entry.first) {
+        unique.back().second = entry.second;
+      } else {
+        unique.emplace_back(std::move(entry));
       }
-      frequency_count[term] = doc[term].GetUint();
     }
+    frequency_count = std::move(unique);
   }
 
   /// <summary>
   /// Σ_{w'∈C}freq(w')
   /// </summary>
-  unsigned int total_count;
+  unsigned int total_count = 0;
 
   /// <summary>
   /// |C|
   /// </summary>
-  unsigned int corpus_size;
+  unsigned int corpus_size = 0;
 
   /// <summary>
-  /// term count
+  /// term count, sorted by term once frequency.py is read
   /// </summary>
-  std::unordered_map<std::string, unsigned int> frequency_count;
+  std::vector<std::pair<std::string, unsigned int>> frequency_count;
 };
 } // namespace GraphSeg::internal
 
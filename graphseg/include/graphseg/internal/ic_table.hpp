@@ -0,0 +1,218 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_IC_TABLE_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_IC_TABLE_HPP
+
+#include "graphseg/internal/utils/mapped_file.hpp"
+#include "graphseg/internal/vector_format.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace GraphSeg::internal {
+/// <summary>
+/// Precomputed term frequency / information content table
+/// (all integers little-endian)
+///
+///   header (40 bytes)
+///     char[4]  magic "GSIC"
+///     uint32   version (1)
+///     uint32   count of terms
+///     float32  information content of unseen term
+///     uint64   |C| (corpus_size)
+///     uint64   Σ_{w'∈C}freq(w') (total_count)
+///     uint64   byte size of string pool
+///   entries, sorted by term
+///     count x (uint32 offset in pool, uint32 length, uint32 freq,
+///              float32 information content)
+///   string pool
+/// </summary>
+class ICTable {
+public:
+  static constexpr char MAGIC[4] = {'G', 'S', 'I', 'C'};
+  static constexpr uint32_t VERSION = 1;
+  static constexpr size_t HEADER_SIZE = 40;
+  static constexpr size_t ENTRY_SIZE = 16;
+
+  /// <summary>
+  /// information content, same definition as Embedding used to compute
+  /// -log((freq + 1) / (|C| + Σfreq))
+  /// </summary>
+  static double InformationContent(uint64_t freq, uint64_t corpus_size,
+                                   uint64_t total_count) {
+    return -std::log(static_cast<double>(freq + 1) /
+                     static_cast<double>(corpus_size + total_count));
+  }
+
+  /// <summary>
+  /// serialize term counts
+  /// </summary>
+  static void Write(std::ostream &os,
+                    const std::unordered_map<std::string, uint32_t> &counts) {
+    std::vector<std::pair<std::string_view, uint32_t>> entries(counts.begin(),
+                                                               counts.end());
+    std::sort(entries.begin(), entries.end());
+
+    const uint64_t corpus_size = entries.size();
+    uint64_t total_count = 0;
+    uint64_t pool_size = 0;
+    for (const auto &[term, count] : entries) {
+      total_count += count;
+      pool_size += term.size();
+    }
+
+    os.write(MAGIC, 4);
+    VectorFormat::WriteUint32(os, VERSION);
+    VectorFormat::WriteUint32(os, static_cast<uint32_t>(entries.size()));
+    WriteFloat(os, InformationContent(0, corpus_size, total_count));
+    VectorFormat::WriteUint64(os, corpus_size);
+    VectorFormat::WriteUint64(os, total_count);
+    VectorFormat::WriteUint64(os, pool_size);
+
+    uint32_t offset = 0;
+    for (const auto &[term, count] : entries) {
+      VectorFormat::WriteUint32(os, offset);
+      VectorFormat::WriteUint32(os, static_cast<uint32_t>(term.size()));
+      VectorFormat::WriteUint32(os, count);
+      WriteFloat(os, InformationContent(count, corpus_size, total_count));
+      offset += static_cast<uint32_t>(term.size());
+    }
+    for (const auto &entry : entries) {
+      os.write(entry.first.data(),
+               static_cast<std::streamsize>(entry.first.size()));
+    }
+  }
+
+  /// <summary>
+  /// map table file
+  /// </summary>
+  explicit ICTable(const std::string &path)
+      : file(std::make_unique<utils::MappedFile>(path)) {
+    Parse(file->Data(), file->Size(), path);
+  }
+
+  /// <summary>
+  /// build table in memory from term counts
+  /// </summary>
+  static std::shared_ptr<const ICTable>
+  FromCounts(const std::unordered_map<std::string, uint32_t> &counts) {
+    std::ostringstream os;
+    Write(os, counts);
+    return std::shared_ptr<const ICTable>(new ICTable(os.str(), InMemory{}));
+  }
+
+  /// <summary>
+  /// term frequency in corpus, 0 if unseen
+  /// </summary>
+  uint32_t GetFrequency(std::string_view term) const {
+    const auto entry = Find(term);
+    return entry != nullptr ? VectorFormat::ReadUint32(entry + 8) : 0;
+  }
+
+  /// <summary>
+  /// precomputed information content of term
+  /// </summary>
+  double InformationContent(std::string_view term) const {
+    const auto entry = Find(term);
+    return entry != nullptr ? ReadFloat(entry + 12) : unseen_ic;
+  }
+
+  /// <summary>
+  /// |C|
+  /// </summary>
+  uint64_t GetCorpusSize() const noexcept { return corpus_size; }
+
+  /// <summary>
+  /// Σ_{w'∈C}freq(w')
+  /// </summary>
+  uint64_t GetTotalCount() const noexcept { return total_count; }
+
+  size_t Size() const noexcept { return count; }
+
+private:
+  static void WriteFloat(std::ostream &os, double value) {
+    const auto f = static_cast<float>(value);
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    VectorFormat::WriteUint32(os, bits);
+  }
+
+  static float ReadFloat(const char *p) {
+    const auto bits = VectorFormat::ReadUint32(p);
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+  }
+
+  struct InMemory {};
+
+  ICTable(std::string &&_buffer, InMemory) : buffer(std::move(_buffer)) {
+    Parse(buffer.data(), buffer.size(), "table");
+  }
+
+  void Parse(const char *data, size_t size, const std::string &path) {
+    if (size < HEADER_SIZE || std::memcmp(data, MAGIC, 4) != 0) {
+      throw std::runtime_error(path +
+                               " is not an information content table");
+    }
+    if (VectorFormat::ReadUint32(data + 4) != VERSION) {
+      throw std::runtime_error(path + ": unsupported version");
+    }
+    count = VectorFormat::ReadUint32(data + 8);
+    unseen_ic = ReadFloat(data + 12);
+    corpus_size = VectorFormat::ReadUint64(data + 16);
+    total_count = VectorFormat::ReadUint64(data + 24);
+    const auto pool_size = VectorFormat::ReadUint64(data + 32);
+    if (ENTRY_SIZE * count + pool_size > size - HEADER_SIZE) {
+      throw std::runtime_error(path + ": truncated");
+    }
+    entries = data + HEADER_SIZE;
+    pool = entries + ENTRY_SIZE * count;
+  }
+
+  std::string_view Term(size_t idx) const {
+    const auto entry = entries + ENTRY_SIZE * idx;
+    return std::string_view(pool + VectorFormat::ReadUint32(entry),
+                            VectorFormat::ReadUint32(entry + 4));
+  }
+
+  /// <summary>
+  /// binary search on sorted entries
+  /// </summary>
+  const char *Find(std::string_view term) const {
+    size_t low = 0, high = count;
+    while (low < high) {
+      const auto mid = low + (high - low) / 2;
+      const auto cmp = Term(mid).compare(term);
+      if (cmp == 0) {
+        return entries + ENTRY_SIZE * mid;
+      }
+      if (cmp < 0) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    return nullptr;
+  }
+
+  std::unique_ptr<utils::MappedFile> file;
+  std::string buffer;
+  size_t count = 0;
+  float unseen_ic = 0.0f;
+  uint64_t corpus_size = 0;
+  uint64_t total_count = 0;
+  const char *entries = nullptr;
+  const char *pool = nullptr;
+};
+} // namespace GraphSeg::internal
+
+#endif
@@ -0,0 +1,385 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_SEGMENT_CACHE_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_SEGMENT_CACHE_HPP
+
+#include "graphseg/internal/vector_format.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace GraphSeg::internal {
+using Vertex = unsigned int;
+
+/// <summary>
+/// FNV-1a of normalized text and segmentation parameters, plus normalized
+/// length as a cheap second check against collisions
+/// </summary>
+struct SegmentCacheKey {
+  uint64_t hash = 0;
+  uint64_t length = 0;
+
+  bool operator==(const SegmentCacheKey &other) const noexcept {
+    return hash == other.hash && length == other.length;
+  }
+
+  std::string ToString() const {
+    char buf[40];
+    std::snprintf(buf, sizeof(buf), "%016llx-%llx",
+                  static_cast<unsigned long long>(hash),
+                  static_cast<unsigned long long>(length));
+    return buf;
+  }
+};
+
+struct SegmentCacheKeyHash {
+  size_t operator()(const SegmentCacheKey &key) const noexcept {
+    return static_cast<size_t>(key.hash ^ key.length);
+  }
+};
+
+/// <summary>
+/// result of one document, enough to answer without tagging or graph work
+/// </summary>
+struct CachedSegmentation {
+  size_t sentences = 0;
+  std::vector<std::vector<Vertex>> segments;
+};
+
+/// <summary>
+/// Content-addressed cache of segmentation results: an in-memory LRU in
+/// front of an optional on-disk store, one file per entry
+///
+///   <directory>/<first 2 hex digits>/<key>.gssc
+///     char[4]  magic "GSSC"
+///     uint32   version (1)
+///     uint32   sentences
+///     uint32   count of segments
+///     count x (uint32 size, size x uint32 vertex)
+///
+/// Thread safe. Files are written to a temporary name and renamed, so
+/// several processes may share a directory
+/// </summary>
+class SegmentCache {
+public:
+  static constexpr char MAGIC[4] = {'G', 'S', 'S', 'C'};
+  static constexpr uint32_t VERSION = 1;
+
+  /// <summary>
+  /// capacity: entries kept in memory, 0 disables the memory tier.
+  /// directory: on-disk store, empty disables it
+  /// </summary>
+  explicit SegmentCache(size_t _capacity, std::string _directory = "")
+      : capacity(_capacity), directory(std::move(_directory)) {
+    if (!directory.empty()) {
+      std::filesystem::create_directories(directory);
+    }
+  }
+
+  SegmentCache(const SegmentCache &) = delete;
+  SegmentCache &operator=(const SegmentCache &) = delete;
+
+  /// <summary>
+  /// Key of text segmented with given parameters. Runs of whitespace are
+  /// folded into one space and blank lines are dropped, so re-crawls that
+  /// differ only in layout share an entry; line breaks are kept because
+  /// they separate sentences of some inputs. kind tells apart inputs that
+  /// are split differently (e.g. ServerOpcode). options are further
+  /// settings that change segments (clique mode, engine, ...), each hashed
+  /// with its position only when it is not 0, so keys of default settings
+  /// stay as they were
+  /// </summary>
+  template <class CharT>
+  static SegmentCacheKey
+  MakeKey(const std::basic_string<CharT> &text, double threshold,
+          double edge_budget, size_t minimum_segment_size,
+          const std::string &model_id, uint32_t kind = 0,
+          std::initializer_list<uint64_t> options = {}) {
+    Fnv1a fnv;
+    uint64_t length = 0;
+    // separator is emitted only when text follows it, so leading and
+    // trailing whitespace never reach the hash
+    uint32_t separator = 0;
+    bool line_empty = true;
+    ForEachCodePoint(text, [&](uint32_t c) {
+      if (c == '\n') {
+        if (!line_empty) {
+          separator = '\n';
+        }
+        line_empty = true;
+      } else if (IsSpace(c)) {
+        if (!line_empty && separator == 0) {
+          separator = ' ';
+        }
+      } else {
+        if (separator != 0 && length > 0) {
+          fnv.Update(separator);
+          ++length;
+        }
+        separator = 0;
+        fnv.Update(c);
+        ++length;
+        line_empty = false;
+      }
+    });
+
+    fnv.Update(kind);
+    fnv.Update(threshold);
+    fnv.Update(edge_budget);
+    fnv.Update(static_cast<uint64_t>(minimum_segment_size));
+    for (const auto c : model_id) {
+      fnv.Update(static_cast<unsigned char>(c));
+    }
+    uint32_t position = 0;
+    for (const auto option : options) {
+      if (option != 0) {
+        fnv.Update(position);
+        fnv.Update(option);
+      }
+      ++position;
+    }
+    return SegmentCacheKey{fnv.Digest(), length};
+  }
+
+  /// <summary>
+  /// whether text is whitespace only, a blank line to MakeKey. inputs
+  /// split by line must skip such lines, or two texts of one key would
+  /// differ in sentences
+  /// </summary>
+  template <class CharT>
+  static bool IsBlank(const std::basic_string<CharT> &text) {
+    bool blank = true;
+    ForEachCodePoint(text, [&](uint32_t c) { blank = blank && IsSpace(c); });
+    return blank;
+  }
+
+  /// <summary>
+  /// stored result of key, from memory or else from disk
+  /// </summary>
+  std::optional<CachedSegmentation> Find(const SegmentCacheKey &key) {
+    if (capacity > 0) {
+      std::lock_guard<std::mutex> lock(mtx);
+      const auto itr = index.find(key);
+      if (itr != index.end()) {
+        entries.splice(entries.begin(), entries, itr->second);
+        ++hits;
+        return itr->second->second;
+      }
+    }
+    if (!directory.empty()) {
+      if (auto value = Load(key)) {
+        Remember(key, *value);
+        ++hits;
+        return value;
+      }
+    }
+    ++misses;
+    return std::nullopt;
+  }
+
+  void Insert(const SegmentCacheKey &key, const CachedSegmentation &value) {
+    Remember(key, value);
+    if (!directory.empty()) {
+      Store(key, value);
+    }
+  }
+
+  uint64_t GetHits() const noexcept { return hits.load(); }
+
+  uint64_t GetMisses() const noexcept { return misses.load(); }
+
+private:
+  class Fnv1a {
+  public:
+    void Update(unsigned char byte) noexcept {
+      state ^= byte;
+      state *= 0x100000001b3ULL;
+    }
+
+    void Update(uint32_t v) noexcept {
+      for (size_t i = 0; i < 4; ++i) {
+        Update(static_cast<unsigned char>(v >> (8 * i)));
+      }
+    }
+
+    void Update(uint64_t v) noexcept {
+      Update(static_cast<uint32_t>(v));
+      Update(static_cast<uint32_t>(v >> 32));
+    }
+
+    void Update(double v) noexcept {
+      uint64_t bits;
+      std::memcpy(&bits, &v, sizeof(bits));
+      Update(bits);
+    }
+
+    uint64_t Digest() const noexcept { return state; }
+
+  private:
+    uint64_t state = 0xcbf29ce484222325ULL;
+  };
+
+  static bool IsSpace(uint32_t c) noexcept {
+    // U+3000: ideographic space, U+FEFF: byte order mark
+    return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v' ||
+           c == 0x3000 || c == 0xfeff;
+  }
+
+  /// <summary>
+  /// wide strings hold code points already, UTF-8 is decoded so that both
+  /// give the same key. malformed bytes are passed through as they are
+  /// </summary>
+  template <class CharT, class F>
+  static void ForEachCodePoint(const std::basic_string<CharT> &text, F &&f) {
+    if constexpr (sizeof(CharT) > 1) {
+      for (const auto c : text) {
+        f(static_cast<uint32_t>(c));
+      }
+    } else {
+      const auto u = reinterpret_cast<const unsigned char *>(text.data());
+      const auto size = text.size();
+      for (size_t i = 0; i < size;) {
+        const uint32_t lead = u[i];
+        // count of continuation bytes
+        const size_t n = lead < 0x80           ? 0
+                         : (lead >> 5) == 0x6  ? 1
+                         : (lead >> 4) == 0xe  ? 2
+                         : (lead >> 3) == 0x1e ? 3
+                                               : 0;
+        bool valid = n > 0 && i + n < size;
+        uint32_t c = lead & (0x3fu >> n);
+        for (size_t j = 1; valid && j <= n; ++j) {
+          valid = (u[i + j] & 0xc0u) == 0x80u;
+          c = c << 6 | (u[i + j] & 0x3fu);
+        }
+        if (!valid) {
+          f(lead);
+          ++i;
+          continue;
+        }
+        f(c);
+        i += n + 1;
+      }
+    }
+  }
+
+  void Remember(const SegmentCacheKey &key, const CachedSegmentation &value) {
+    if (capacity == 0) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    const auto itr = index.find(key);
+    if (itr != index.end()) {
+      entries.splice(entries.begin(), entries, itr->second);
+      return;
+    }
+    entries.emplace_front(key, value);
+    index.emplace(key, entries.begin());
+    if (entries.size() > capacity) {
+      index.erase(entries.back().first);
+      entries.pop_back();
+    }
+  }
+
+  std::filesystem::path PathOf(const SegmentCacheKey &key) const {
+    const auto name = key.ToString();
+    return std::filesystem::path(directory) / name.substr(0, 2) /
+           (name + ".gssc");
+  }
+
+  std::optional<CachedSegmentation> Load(const SegmentCacheKey &key) const {
+    std::ifstream ifs(PathOf(key), std::ios::binary);
+    if (!ifs) {
+      return std::nullopt;
+    }
+    const std::string buffer((std::istreambuf_iterator<char>(ifs)),
+                             std::istreambuf_iterator<char>());
+    // a truncated or foreign file is a miss, it is overwritten later
+    if (buffer.size() < 16 || std::memcmp(buffer.data(), MAGIC, 4) != 0 ||
+        VectorFormat::ReadUint32(buffer.data() + 4) != VERSION) {
+      return std::nullopt;
+    }
+    CachedSegmentation value;
+    value.sentences = VectorFormat::ReadUint32(buffer.data() + 8);
+    const auto count = VectorFormat::ReadUint32(buffer.data() + 12);
+    size_t offset = 16;
+    for (uint32_t i = 0; i < count; ++i) {
+      if (offset + 4 > buffer.size()) {
+        return std::nullopt;
+      }
+      const size_t size = VectorFormat::ReadUint32(buffer.data() + offset);
+      offset += 4;
+      if (size > (buffer.size() - offset) / 4) {
+        return std::nullopt;
+      }
+      auto &segment = value.segments.emplace_back(size);
+      for (auto &vertex : segment) {
+        vertex = VectorFormat::ReadUint32(buffer.data() + offset);
+        offset += 4;
+      }
+    }
+    return value;
+  }
+
+  void Store(const SegmentCacheKey &key,
+             const CachedSegmentation &value) const {
+    const auto path = PathOf(key);
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    std::ostringstream suffix;
+    // thread ids repeat across processes sharing the directory
+    suffix << ".tmp." << getpid() << '.' << std::this_thread::get_id();
+    auto tmp = path;
+    tmp += suffix.str();
+    {
+      std::ofstream ofs(tmp, std::ios::binary);
+      ofs.write(MAGIC, 4);
+      VectorFormat::WriteUint32(ofs, VERSION);
+      VectorFormat::WriteUint32(ofs, static_cast<uint32_t>(value.sentences));
+      VectorFormat::WriteUint32(ofs,
+                                static_cast<uint32_t>(value.segments.size()));
+      for (const auto &segment : value.segments) {
+        VectorFormat::WriteUint32(ofs, static_cast<uint32_t>(segment.size()));
+        for (const auto vertex : segment) {
+          VectorFormat::WriteUint32(ofs, vertex);
+        }
+      }
+      if (!ofs) {
+        // the cache is an optimization, a full disk must not fail callers
+        ofs.close();
+        std::filesystem::remove(tmp, ec);
+        return;
+      }
+    }
+    std::filesystem::rename(tmp, path, ec);
+  }
+
+  size_t capacity;
+  std::string directory;
+
+  std::mutex mtx;
+  std::list<std::pair<SegmentCacheKey, CachedSegmentation>> entries;
+  std::unordered_map<SegmentCacheKey, decltype(entries)::iterator,
+                     SegmentCacheKeyHash>
+      index;
+
+  std::atomic<uint64_t> hits{0};
+  std::atomic<uint64_t> misses{0};
+};
+} // namespace GraphSeg::internal
+
+#endif
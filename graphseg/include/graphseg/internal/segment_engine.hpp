@@ -0,0 +1,72 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_SEGMENT_ENGINE_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_SEGMENT_ENGINE_HPP
+
+#include "graphseg/internal/segmentation_stats.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace GraphSeg {
+/// <summary>
+/// How SegmentationContainer turns sentence similarity into segments.
+/// CLIQUE: maximal cliques of the sentence graph, merged (Segmentable).
+/// COHERENCE: boundaries maximizing similarity within segments by dynamic
+/// programming (CoherenceSegmentable), no graph is built
+/// </summary>
+enum class SegmentationEngine { CLIQUE, COHERENCE };
+} // namespace GraphSeg
+
+namespace GraphSeg::internal {
+using Vertex = unsigned int;
+
+/// <summary>
+/// Segments, settings and stats shared by segmentation engines, so that
+/// SegmentationContainer hands out the result of any of them alike
+/// </summary>
+class SegmentEngine {
+public:
+  using Segment = std::pmr::vector<Vertex>;
+  using SegmentList = std::pmr::vector<Segment>;
+
+  virtual ~SegmentEngine() = default;
+
+  /// <summary>
+  /// minimum segment size
+  /// </summary>
+  size_t minimum_segment_size = 2;
+
+  /// <summary>
+  /// calculated segments
+  /// </summary>
+  mutable SegmentList segments;
+
+  /// <summary>
+  /// set when a deadline made the engine settle for cheaper segments
+  /// </summary>
+  bool degraded = false;
+
+  /// <summary>
+  /// time and counters of segment passes (GRAPHSEG_STATS only)
+  /// </summary>
+  GRAPHSEG_INLINE_CONST SegmentationStats &GetStats() const & {
+    return stats;
+  }
+
+protected:
+  /// <summary>
+  /// segments are allocated from resource
+  /// </summary>
+  explicit SegmentEngine(
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : segments(resource) {}
+
+  std::pmr::memory_resource *Resource() const {
+    return segments.get_allocator().resource();
+  }
+
+  SegmentationStats stats;
+};
+} // namespace GraphSeg::internal
+
+#endif
@@ -2,14 +2,18 @@
 #define GRAPHSEG_CPP_GRAPHSEG_SEGMENTABLE_HPP
 
 #include "graphseg/embedding.hpp"
+#include "graphseg/internal/segment_engine.hpp"
 #include "graphseg/internal/segment_state.hpp"
+#include "graphseg/internal/segmentation_stats.hpp"
 #include "graphseg/internal/utils/custom_operator.hpp"
+#include "graphseg/internal/utils/trace.hpp"
 #include "graphseg/language.hpp"
 #include "graphseg/segmentation_container.hpp"
 
 #include <algorithm>
 #include <array>
 #include <list>
+#include <memory_resource>
 #include <optional>
 #include <set>
 #include <stdexcept>
@@ -19,7 +23,6 @@
 
 namespace GraphSeg::internal {
 using namespace GraphSeg::internal::utils;
-using Vertex = unsigned int;
 
 class SegmentChecker {
 private:
@@ -63,22 +66,12 @@ protected:
 };
 
 template <class Graph, int VectorDim, Lang LangType = Lang::EN>
-class Segmentable : public SegmentChecker {
+class Segmentable : public SegmentEngine, public SegmentChecker {
 public:
-  /// <summary>
-  /// minimum segment size
-  /// </summary>
-  size_t minimum_segment_size = 2;
-
-  /// <summary>
-  /// calculated segments
-  /// <summary>
-  mutable std::vector<std::vector<Vertex>> segments;
-
   /// <summary>
   /// prev state segments
   /// </summary>
-  mutable std::vector<std::vector<Vertex>> old_segments;
+  mutable SegmentList old_segments;
 
   /// <summary>
   /// segment checked flag
@@ -101,7 +94,13 @@ private:
 public:
   explicit Segmentable() = default;
 
-  explicit Segmentable(std::shared_ptr<Graph> g) : graph(g) {}
+  /// <summary>
+  /// segments and temporaries of passes are allocated from resource
+  /// </summary>
+  explicit Segmentable(
+      std::shared_ptr<Graph> g,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : SegmentEngine(resource), old_segments(resource), graph(g) {}
 
 private:
   /// <summary>
@@ -110,8 +109,7 @@ private:
   /// maximum clique, the topic indicated by the sentence should be referred by
   /// second segment
   /// </summary>
-  bool IsMergable(const std::vector<Vertex> &sg1,
-                  const std::vector<Vertex> &sg2) {
+  bool IsMergable(const Segment &sg1, const Segment &sg2) {
     for (const auto &s : sg1) {
       for (const auto &maximum_cliques : graph->GetMaximumClique(s)) {
         const auto &duplicated = sg2 & maximum_cliques;
@@ -123,9 +121,12 @@ private:
     return false;
   }
 
-  std::vector<Vertex> GetMergedSegment(const std::vector<Vertex> &first_itr,
-                                       const std::vector<Vertex> second_itr) {
-    std::vector<Vertex> merged_segment = first_itr;
+  Segment GetMergedSegment(const Segment &first_itr,
+                           const Segment &second_itr) {
+    Segment merged_segment(Resource());
+    merged_segment.reserve(first_itr.size() + second_itr.size());
+    merged_segment.insert(merged_segment.end(), first_itr.begin(),
+                          first_itr.end());
     merged_segment.insert(merged_segment.end(), second_itr.begin(),
                           second_itr.end());
     return merged_segment;
@@ -136,6 +137,17 @@ public:
   /// construct segment from maximum clique
   /// </summary>
   void ConstructSegment(const Embedding<VectorDim, LangType> &embedding) {
+    Construct([&](Vertex a, Vertex b) {
+      return embedding.NormalizedSimilarity(graph->GetSentence(a),
+                                            graph->GetSentence(b));
+    });
+  }
+
+  /// <summary>
+  /// construct segment, relatedness(a, b) of sentences a and b decides
+  /// where small segments are merged
+  /// </summary>
+  template <class Relatedness> void Construct(const Relatedness &relatedness) {
     while (current_status != GraphSeg::SegmentStatus::TERMINATED) {
       switch (current_status) {
       case GraphSeg::SegmentStatus::NONE:
@@ -148,7 +160,7 @@ public:
         current_status = GraphSeg::SegmentStatus::MERGED;
         break;
       case GraphSeg::SegmentStatus::MERGED:
-        ConstructSmallSegment(embedding);
+        ConstructSmallSegment(relatedness);
         current_status = GraphSeg::SegmentStatus::SMALLED;
         break;
       case GraphSeg::SegmentStatus::SMALLED:
@@ -161,14 +173,15 @@ public:
   }
 
 private:
-  double SegmentRelatedness(const Embedding<VectorDim, LangType> &embedding,
-                            const std::vector<Vertex> &seg1,
-                            const std::vector<Vertex> &seg2) {
+  template <class Relatedness>
+  double SegmentRelatedness(const Relatedness &relatedness,
+                            const Segment &seg1, const Segment &seg2) {
+    GRAPHSEG_STATS_ONLY(stats.similarity_evaluations +=
+                        seg1.size() * seg2.size();)
     double rel = 1.0;
     for (const auto &sent1 : seg1) {
       for (const auto &sent2 : seg2) {
-        rel += embedding.NormalizedSimilarity(graph->GetSentence(sent1),
-                                              graph->GetSentence(sent2));
+        rel += relatedness(sent1, sent2);
       }
     }
     return rel / static_cast<double>(seg1.size() * seg2.size());
@@ -178,9 +191,11 @@ private:
   /// instantiate segment
   /// </summary>
   void ConstructInitSegment() {
+    GRAPHSEG_TRACE_SCOPE("Segmentable::ConstructInitSegment");
+    GRAPHSEG_STATS_PHASE(stats, SegmentationPhase::INIT);
     std::vector<bool> check(graph->GetGraphSize(), false);
     for (const auto &clique : graph->GetMaximumClique()) {
-      std::vector<Vertex> single_segment;
+      Segment single_segment(Resource());
       for (const auto &node : clique) {
         if (check[node] == true) {
           continue;
@@ -207,6 +222,7 @@ private:
 
     InstantiateSegmentChecker(segments.size());
     std::sort(segments.begin(), segments.end());
+    GRAPHSEG_STATS_ONLY(stats.initial_segments = segments.size();)
 
 #ifdef DEBUG
     std::cout << "===== Initial Segment =====" << std::endl;
@@ -215,20 +231,22 @@ private:
   }
 
   void ConstructMergedSegment() {
+    GRAPHSEG_TRACE_SCOPE("Segmentable::ConstructMergedSegment");
+    GRAPHSEG_STATS_PHASE(stats, SegmentationPhase::MERGE);
     // to avoid searching same segment twice, memory searched segment whether it
     // can merge std::vector<bool> segment_memo(segments.size(), false);
-    std::vector<std::vector<Vertex>> next_segment;
+    SegmentList next_segment(Resource());
 
     for (size_t i = 0; i < segments.size() - 1; ++i) {
-      const auto current_segment = segments[i];
-      const auto adjacent_segment = segments[i + 1];
+      const auto &current_segment = segments[i];
+      const auto &adjacent_segment = segments[i + 1];
 
       if (CheckSegment(i).value()) {
         continue;
       }
 
       if (IsMergable(current_segment, adjacent_segment)) {
-        std::vector<Vertex> merged_segment =
+        auto merged_segment =
             GetMergedSegment(current_segment, adjacent_segment);
         MarkForward(i);
 
@@ -236,7 +254,7 @@ private:
         for (size_t j = 2; i + j < segments.size() &&
                            IsMergable(merged_segment, segments[i + j]);
              ++j) {
-          const auto offspring_segment = segments[i + j];
+          const auto &offspring_segment = segments[i + j];
           merged_segment = GetMergedSegment(merged_segment, offspring_segment);
           Mark(i + j);
         }
@@ -254,10 +272,12 @@ private:
       next_segment.emplace_back(segments[segment_last_idx]);
     }
 
-    old_segments = segments;
+    old_segments = std::move(segments);
     segments.clear();
     InstantiateSegmentChecker(next_segment.size());
-    segments = next_segment;
+    segments = std::move(next_segment);
+    GRAPHSEG_STATS_ONLY(stats.clique_merges =
+                            old_segments.size() - segments.size();)
 
 #ifdef DEBUG
     std::cout << "===== Merged Segment =====" << std::endl;
@@ -268,12 +288,15 @@ private:
   /// <summary>
   /// merge segments that don't have length higher than thereshold
   /// </summary>
-  void ConstructSmallSegment(const Embedding<VectorDim, LangType> &embedding) {
-    std::vector<std::vector<Vertex>> next_segments;
+  template <class Relatedness>
+  void ConstructSmallSegment(const Relatedness &relatedness) {
+    GRAPHSEG_TRACE_SCOPE("Segmentable::ConstructSmallSegment");
+    GRAPHSEG_STATS_PHASE(stats, SegmentationPhase::SMALL);
+    SegmentList next_segments(Resource());
 
     for (size_t i = 0; i < segments.size() - 1; ++i) {
-      const auto current_segment = segments[i];
-      const auto next_segment = segments[i + 1];
+      const auto &current_segment = segments[i];
+      const auto &next_segment = segments[i + 1];
 
       if (CheckSegment(i).value()) {
         continue;
@@ -286,14 +309,14 @@ private:
           MarkForward(i);
           next_segments.emplace_back(merged_segment);
         } else {
-          const auto prev_segment = segments[i - 1];
-          std::vector<Vertex> merged_segment;
+          const auto &prev_segment = segments[i - 1];
+          Segment merged_segment(Resource());
 
           if (!CheckSegment(i - 1).value() && !CheckSegment(i + 1).value()) {
-            auto before =
-                SegmentRelatedness(embedding, current_segment, prev_segment);
-            auto after =
-                SegmentRelatedness(embedding, current_segment, next_segment);
+            auto before = SegmentRelatedness(relatedness, current_segment,
+                                             prev_segment);
+            auto after = SegmentRelatedness(relatedness, current_segment,
+                                             next_segment);
 
             if (before > after) {
               merged_segment = GetMergedSegment(prev_segment, current_segment);
@@ -325,10 +348,12 @@ private:
       next_segments.emplace_back(segments[last_segment_idx]);
     }
 
-    old_segments = segments;
+    old_segments = std::move(segments);
     segments.clear();
     InstantiateSegmentChecker(next_segments.size());
-    segments = next_segments;
+    segments = std::move(next_segments);
+    GRAPHSEG_STATS_ONLY(stats.small_segment_merges =
+                            old_segments.size() - segments.size();)
 
 #ifdef DEBUG
     std::cout << "===== Small Segment =====" << std::endl;
@@ -0,0 +1,195 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_SEGMENTATION_STATS_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_SEGMENTATION_STATS_HPP
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+
+/// <summary>
+/// Statistics are collected only when GRAPHSEG_STATS is defined. Otherwise
+/// the macros below expand to nothing and all counters stay zero
+/// </summary>
+#ifdef GRAPHSEG_STATS
+#define GRAPHSEG_STATS_ONLY(...) __VA_ARGS__
+#define GRAPHSEG_STATS_PHASE(stats, phase)                                    \
+  ::GraphSeg::internal::PhaseTimer graphseg_phase_timer((stats), (phase))
+#else
+#define GRAPHSEG_STATS_ONLY(...)
+#define GRAPHSEG_STATS_PHASE(stats, phase)
+#endif
+
+namespace GraphSeg {
+enum class SegmentationPhase {
+  VOCABULARY,
+  EMBEDDING,
+  EDGE,
+  CLIQUE,
+  INIT,
+  MERGE,
+  SMALL,
+  COHERENCE
+};
+
+static constexpr size_t SegmentationPhaseSize = 8;
+
+/// <summary>
+/// counters of one segmentation
+/// </summary>
+struct SegmentationStats {
+  /// <summary>
+  /// wall time per phase in seconds
+  /// </summary>
+  std::array<double, SegmentationPhaseSize> elapsed{};
+
+  /// <summary>
+  /// sentence similarity evaluations while building edges and merging small
+  /// segments
+  /// </summary>
+  size_t similarity_evaluations = 0;
+
+  /// <summary>
+  /// sentence pairs skipped by an upper bound below threshold
+  /// </summary>
+  size_t pruned_pairs = 0;
+
+  size_t edges = 0;
+  size_t cliques = 0;
+  size_t max_clique_size = 0;
+
+  /// <summary>
+  /// Bron-Kerbosch recursive calls and maximum recursion depth
+  /// </summary>
+  size_t clique_search_calls = 0;
+  size_t clique_search_depth = 0;
+
+  /// <summary>
+  /// segments after initial pass and merges done by later passes
+  /// </summary>
+  size_t initial_segments = 0;
+  size_t clique_merges = 0;
+  size_t small_segment_merges = 0;
+
+  /// <summary>
+  /// plans chosen by cost model (see ExecutionPlan), those of them with
+  /// banded edges (widest band) or greedy cliques, pairs sampled for them,
+  /// and their estimated edges, similarity evaluations and clique search
+  /// calls
+  /// </summary>
+  size_t plans = 0;
+  size_t banded_plans = 0;
+  size_t plan_edge_band = 0;
+  size_t greedy_plans = 0;
+  size_t sampled_pairs = 0;
+  double estimated_edges = 0.0;
+  double estimated_edge_cost = 0.0;
+  double estimated_clique_cost = 0.0;
+
+  /// <summary>
+  /// phases (edges, cliques, coherence) that fell back to cheaper work
+  /// because the deadline passed
+  /// </summary>
+  size_t deadline_fallbacks = 0;
+
+  double &Elapsed(SegmentationPhase phase) {
+    return elapsed[static_cast<size_t>(phase)];
+  }
+
+  double Elapsed(SegmentationPhase phase) const {
+    return elapsed[static_cast<size_t>(phase)];
+  }
+
+  /// <summary>
+  /// combine stats collected by different components
+  /// </summary>
+  SegmentationStats &operator+=(const SegmentationStats &other) {
+    for (size_t i = 0; i < SegmentationPhaseSize; ++i) {
+      elapsed[i] += other.elapsed[i];
+    }
+    similarity_evaluations += other.similarity_evaluations;
+    pruned_pairs += other.pruned_pairs;
+    edges += other.edges;
+    cliques += other.cliques;
+    max_clique_size = std::max(max_clique_size, other.max_clique_size);
+    clique_search_calls += other.clique_search_calls;
+    clique_search_depth =
+        std::max(clique_search_depth, other.clique_search_depth);
+    initial_segments += other.initial_segments;
+    clique_merges += other.clique_merges;
+    small_segment_merges += other.small_segment_merges;
+    plans += other.plans;
+    banded_plans += other.banded_plans;
+    plan_edge_band = std::max(plan_edge_band, other.plan_edge_band);
+    greedy_plans += other.greedy_plans;
+    sampled_pairs += other.sampled_pairs;
+    estimated_edges += other.estimated_edges;
+    estimated_edge_cost += other.estimated_edge_cost;
+    estimated_clique_cost += other.estimated_clique_cost;
+    deadline_fallbacks += other.deadline_fallbacks;
+    return *this;
+  }
+};
+
+inline std::ostream &operator<<(std::ostream &os,
+                                const SegmentationStats &stats) {
+  static constexpr const char *names[SegmentationPhaseSize] = {
+      "vocabulary", "embedding", "edge", "clique", "init", "merge", "small",
+      "coherence"};
+  for (size_t i = 0; i < SegmentationPhaseSize; ++i) {
+    os << names[i] << ": " << stats.elapsed[i] << "s" << std::endl;
+  }
+  os << "similarity evaluations: " << stats.similarity_evaluations << std::endl
+     << "pruned pairs: " << stats.pruned_pairs << std::endl
+     << "edges: " << stats.edges << std::endl
+     << "cliques: " << stats.cliques << " (max size "
+     << stats.max_clique_size << ")" << std::endl
+     << "clique search calls: " << stats.clique_search_calls << " (depth "
+     << stats.clique_search_depth << ")" << std::endl
+     << "initial segments: " << stats.initial_segments << std::endl
+     << "clique merges: " << stats.clique_merges << std::endl
+     << "small segment merges: " << stats.small_segment_merges << std::endl;
+  if (stats.plans != 0) {
+    os << "plans: " << stats.plans << " (banded " << stats.banded_plans
+       << ", band " << stats.plan_edge_band << ", greedy "
+       << stats.greedy_plans << ", sampled pairs " << stats.sampled_pairs
+       << ")" << std::endl
+       << "estimated edges: " << stats.estimated_edges << std::endl
+       << "estimated cost: " << stats.estimated_edge_cost
+       << " similarity evaluations, " << stats.estimated_clique_cost
+       << " clique search calls" << std::endl;
+  }
+  if (stats.deadline_fallbacks != 0) {
+    os << "deadline fallbacks: " << stats.deadline_fallbacks << std::endl;
+  }
+  return os;
+}
+} // namespace GraphSeg
+
+namespace GraphSeg::internal {
+/// <summary>
+/// add lifetime of scope to elapsed time of phase
+/// </summary>
+class PhaseTimer {
+public:
+  PhaseTimer(SegmentationStats &_stats, SegmentationPhase _phase)
+      : stats(_stats), phase(_phase),
+        begin(std::chrono::steady_clock::now()) {}
+
+  PhaseTimer(const PhaseTimer &) = delete;
+  PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+  ~PhaseTimer() {
+    stats.Elapsed(phase) += std::chrono::duration<double>(
+                                std::chrono::steady_clock::now() - begin)
+                                .count();
+  }
+
+private:
+  SegmentationStats &stats;
+  SegmentationPhase phase;
+  std::chrono::steady_clock::time_point begin;
+};
+} // namespace GraphSeg::internal
+
+#endif
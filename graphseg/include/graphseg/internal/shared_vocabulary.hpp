@@ -0,0 +1,230 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_SHARED_VOCABULARY_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_SHARED_VOCABULARY_HPP
+
+#include "graphseg/internal/utils/vector_kernel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace GraphSeg::internal {
+/// <summary>
+/// Process-wide, append-only vocabulary: word vector, norm and information
+/// content of every term resolved by any document so far, so that common
+/// terms are fetched and stored once per process instead of once per
+/// document.
+/// Find() takes no lock. Published entries never move or change, and the
+/// open-addressing index is replaced by a larger copy instead of being
+/// resized in place; old generations stay readable until the vocabulary
+/// is destroyed. Publish() serializes writers on a mutex
+/// </summary>
+class SharedVocabulary {
+public:
+  struct Entry {
+    std::string term;
+    size_t hash = 0;
+
+    /// <summary>
+    /// Dimension() values, null only for stop words published while the
+    /// dimension was still unknown
+    /// </summary>
+    const double *vector = nullptr;
+
+    /// <summary>
+    /// 0 for stop words
+    /// </summary>
+    double norm = 0.0;
+
+    double information_content = 0.0;
+  };
+
+  /// <summary>
+  /// dimension: of word vectors, 0 to take it from the first published one
+  /// </summary>
+  explicit SharedVocabulary(size_t _dimension = 0) : dimension(_dimension) {
+    tables.emplace_back(std::make_unique<Table>(INITIAL_CAPACITY));
+    table.store(tables.back().get(), std::memory_order_release);
+  }
+
+  SharedVocabulary(const SharedVocabulary &) = delete;
+  SharedVocabulary &operator=(const SharedVocabulary &) = delete;
+
+  /// <summary>
+  /// published entry of term, null if no document resolved it yet
+  /// </summary>
+  const Entry *Find(std::string_view term) const noexcept {
+    const auto *t = table.load(std::memory_order_acquire);
+    const auto h = Hash(term);
+    // load factor stays below 1/2, so probing always reaches an empty slot
+    for (size_t i = h & t->mask;; i = (i + 1) & t->mask) {
+      const auto *entry = t->slots[i].load(std::memory_order_acquire);
+      if (entry == nullptr) {
+        return nullptr;
+      }
+      if (entry->hash == h && entry->term == term) {
+        return entry;
+      }
+    }
+  }
+
+  /// <summary>
+  /// Add term with a copy of vector (dim values, null for stop words).
+  /// If another document published term first, its entry is kept
+  /// </summary>
+  const Entry *Publish(std::string_view term, const double *vector,
+                       size_t dim, double information_content) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (const auto *found = Find(term)) {
+      return found;
+    }
+    if (vector != nullptr) {
+      const auto current = dimension.load(std::memory_order_relaxed);
+      if (dim == 0 || (current != 0 && dim != current)) {
+        throw std::runtime_error(
+            "vector dimension mismatch: expected " + std::to_string(current) +
+            ", got " + std::to_string(dim));
+      }
+      dimension.store(dim, std::memory_order_relaxed);
+    }
+
+    auto &entry = entries.emplace_back();
+    entry.term = term;
+    entry.hash = Hash(term);
+    entry.information_content = information_content;
+    if (dimension.load(std::memory_order_relaxed) != 0) {
+      auto *row = AllocateRow();
+      if (vector != nullptr) {
+        std::copy_n(vector, dim, row);
+        entry.norm = utils::Norm(row, dim);
+      }
+      entry.vector = row;
+    }
+
+    auto *t = tables.back().get();
+    if (entries.size() * 2 > t->mask + 1) {
+      Grow();
+    } else {
+      Place(*t, entry);
+    }
+    size.store(entries.size(), std::memory_order_relaxed);
+    return &entry;
+  }
+
+  /// <summary>
+  /// dimension of word vectors, 0 until the first vector is published
+  /// </summary>
+  size_t Dimension() const noexcept {
+    return dimension.load(std::memory_order_relaxed);
+  }
+
+  /// <summary>
+  /// count of published terms
+  /// </summary>
+  size_t Size() const noexcept { return size.load(std::memory_order_relaxed); }
+
+  /// <summary>
+  /// add terms of one document found (hits) or fetched (misses), counted
+  /// once per document to keep readers off a shared cache line
+  /// </summary>
+  void CountLookups(uint64_t _hits, uint64_t _misses) noexcept {
+    hits.fetch_add(_hits, std::memory_order_relaxed);
+    misses.fetch_add(_misses, std::memory_order_relaxed);
+  }
+
+  uint64_t GetHits() const noexcept { return hits.load(); }
+
+  uint64_t GetMisses() const noexcept { return misses.load(); }
+
+private:
+  static constexpr size_t INITIAL_CAPACITY = 1 << 12;
+  static constexpr size_t ROWS_PER_BLOCK = 256;
+
+  struct Table {
+    explicit Table(size_t capacity)
+        : slots(new std::atomic<const Entry *>[capacity]),
+          mask(capacity - 1) {
+      for (size_t i = 0; i < capacity; ++i) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+      }
+    }
+
+    std::unique_ptr<std::atomic<const Entry *>[]> slots;
+    size_t mask;
+  };
+
+  static size_t Hash(std::string_view term) noexcept {
+    return std::hash<std::string_view>()(term);
+  }
+
+  /// <summary>
+  /// readers may be probing t, so the entry is released after it is filled
+  /// </summary>
+  static void Place(Table &t, const Entry &entry) noexcept {
+    for (size_t i = entry.hash & t.mask;; i = (i + 1) & t.mask) {
+      if (t.slots[i].load(std::memory_order_relaxed) == nullptr) {
+        t.slots[i].store(&entry, std::memory_order_release);
+        return;
+      }
+    }
+  }
+
+  void Grow() {
+    auto next = std::make_unique<Table>(2 * (tables.back()->mask + 1));
+    for (const auto &entry : entries) {
+      Place(*next, entry);
+    }
+    table.store(next.get(), std::memory_order_release);
+    tables.emplace_back(std::move(next));
+  }
+
+  /// <summary>
+  /// zeroed row of Dimension() values, in blocks to keep rows close
+  /// </summary>
+  double *AllocateRow() {
+    const auto dim = dimension.load(std::memory_order_relaxed);
+    if (blocks.empty() || block_used == ROWS_PER_BLOCK) {
+      blocks.emplace_back(std::make_unique<double[]>(ROWS_PER_BLOCK * dim));
+      block_used = 0;
+    }
+    return blocks.back().get() + dim * block_used++;
+  }
+
+  /// <summary>
+  /// current index, read without lock
+  /// </summary>
+  std::atomic<const Table *> table{nullptr};
+
+  std::atomic<size_t> dimension;
+  std::atomic<size_t> size{0};
+  std::atomic<uint64_t> hits{0};
+  std::atomic<uint64_t> misses{0};
+
+  /// <summary>
+  /// everything below is touched by writers only, under mtx
+  /// </summary>
+  std::mutex mtx;
+
+  /// <summary>
+  /// deque never moves published entries
+  /// </summary>
+  std::deque<Entry> entries;
+
+  /// <summary>
+  /// all index generations, older ones may still be probed by readers
+  /// </summary>
+  std::vector<std::unique_ptr<Table>> tables;
+
+  std::vector<std::unique_ptr<double[]>> blocks;
+  size_t block_used = 0;
+};
+} // namespace GraphSeg::internal
+
+#endif
@@ -0,0 +1,227 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_SIMILARITY_MATRIX_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_SIMILARITY_MATRIX_HPP
+
+#include "graphseg/internal/vector_format.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace GraphSeg::internal {
+/// <summary>
+/// Pairwise sentence similarity (SimilarityPolicy) of one document,
+/// so that thresholds and segment sizes can be tuned without tagging and
+/// embedding again (all integers little-endian)
+///
+///   header (28 bytes)
+///     char[4]  magic "GSSM"
+///     uint32   version (2)
+///     uint32   count of sentences
+///     uint32   band, pairs with j - i <= band are stored (0: all pairs)
+///     uint32   similarity policy (SimilarityPolicy::ID)
+///     uint64   count of scores
+///   count of sentences x uint32 term count of sentence
+///   scores x float32, pairs i < j ordered by i then j
+///
+/// version 1 has no policy field (24 bytes header), its scores are those
+/// of TermPairSimilarity
+/// </summary>
+class SimilarityMatrix {
+public:
+  static constexpr char MAGIC[4] = {'G', 'S', 'S', 'M'};
+  static constexpr uint32_t VERSION = 2;
+  static constexpr size_t HEADER_SIZE = 28;
+
+  SimilarityMatrix() = default;
+
+  explicit SimilarityMatrix(size_t _size, size_t _band = 0,
+                            uint32_t _policy = 0)
+      : size(_size), band(_band), policy(_policy), sentence_sizes(_size, 0),
+        scores(Offset(_size), 0.0f) {}
+
+  /// <summary>
+  /// score sentence pairs within band by scorer.Similarity(i, j), the
+  /// Scorer of SimilarityPolicy built over sentences
+  /// </summary>
+  template <class SimilarityPolicy, class Scorer, class SentenceType>
+  static SimilarityMatrix Compute(const Scorer &scorer,
+                                  const std::vector<SentenceType> &sentences,
+                                  size_t band = 0) {
+    SimilarityMatrix matrix(sentences.size(), band, SimilarityPolicy::ID);
+    for (size_t i = 0; i < sentences.size(); ++i) {
+      matrix.SetSentenceSize(i, sentences[i].GetSize());
+      for (size_t j = i + 1; j < sentences.size() && matrix.Contains(i, j);
+           ++j) {
+        matrix.Set(i, j, scorer.Similarity(i, j));
+      }
+    }
+    return matrix;
+  }
+
+  /// <summary>
+  /// read matrix written by Save()
+  /// </summary>
+  static SimilarityMatrix Load(const std::string &path) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) {
+      throw std::runtime_error(path + ": cannot open");
+    }
+    const std::string buffer((std::istreambuf_iterator<char>(ifs)),
+                             std::istreambuf_iterator<char>());
+    if (buffer.size() < 24 || std::memcmp(buffer.data(), MAGIC, 4) != 0) {
+      throw std::runtime_error(path + ": not a similarity matrix");
+    }
+    const auto version = VectorFormat::ReadUint32(buffer.data() + 4);
+    if (version != 1 && version != VERSION) {
+      throw std::runtime_error(path + ": unsupported version");
+    }
+    // version 1 ends its header before the policy field
+    const size_t header_size = version == 1 ? 24 : HEADER_SIZE;
+    if (buffer.size() < header_size) {
+      throw std::runtime_error(path + ": truncated similarity matrix");
+    }
+    const size_t size = VectorFormat::ReadUint32(buffer.data() + 8);
+    const size_t band = VectorFormat::ReadUint32(buffer.data() + 12);
+    const auto count =
+        VectorFormat::ReadUint64(buffer.data() + header_size - 8);
+    // check sizes before allocating: a corrupt header must not request
+    // more memory than the file holds
+    const auto body = buffer.size() - header_size;
+    if (count != Offset(size, band, size) || body % 4 != 0 ||
+        body / 4 != size + count) {
+      throw std::runtime_error(path + ": truncated similarity matrix");
+    }
+    SimilarityMatrix matrix(
+        size, band,
+        version == 1 ? 0 : VectorFormat::ReadUint32(buffer.data() + 16));
+    auto p = buffer.data() + header_size;
+    for (auto &n : matrix.sentence_sizes) {
+      n = VectorFormat::ReadUint32(p);
+      p += 4;
+    }
+    for (auto &score : matrix.scores) {
+      const auto bits = VectorFormat::ReadUint32(p);
+      std::memcpy(&score, &bits, sizeof(score));
+      p += 4;
+    }
+    return matrix;
+  }
+
+  void Write(std::ostream &os) const {
+    os.write(MAGIC, 4);
+    VectorFormat::WriteUint32(os, VERSION);
+    VectorFormat::WriteUint32(os, static_cast<uint32_t>(size));
+    VectorFormat::WriteUint32(os, static_cast<uint32_t>(band));
+    VectorFormat::WriteUint32(os, policy);
+    VectorFormat::WriteUint64(os, scores.size());
+    for (const auto n : sentence_sizes) {
+      VectorFormat::WriteUint32(os, n);
+    }
+    for (const auto score : scores) {
+      uint32_t bits;
+      std::memcpy(&bits, &score, sizeof(bits));
+      VectorFormat::WriteUint32(os, bits);
+    }
+  }
+
+  void Save(const std::string &path) const {
+    std::ofstream ofs(path, std::ios::binary);
+    Write(ofs);
+    if (!ofs) {
+      throw std::runtime_error(path + ": cannot write");
+    }
+  }
+
+  /// <summary>
+  /// count of sentences
+  /// </summary>
+  size_t Size() const noexcept { return size; }
+
+  size_t Band() const noexcept { return band; }
+
+  /// <summary>
+  /// SimilarityPolicy::ID of the scores
+  /// </summary>
+  uint32_t Policy() const noexcept { return policy; }
+
+  /// <summary>
+  /// whether the score of pair is stored
+  /// </summary>
+  bool Contains(size_t i, size_t j) const noexcept {
+    if (i > j) {
+      std::swap(i, j);
+    }
+    return i != j && j < size && (band == 0 || j - i <= band);
+  }
+
+  /// <summary>
+  /// similarity of pair, 0 when it is outside of band
+  /// </summary>
+  double Get(size_t i, size_t j) const noexcept {
+    if (!Contains(i, j)) {
+      return 0.0;
+    }
+    return scores[Index(std::min(i, j), std::max(i, j))];
+  }
+
+  void Set(size_t i, size_t j, double similarity) {
+    if (!Contains(i, j)) {
+      throw std::out_of_range("pair is outside of similarity matrix");
+    }
+    scores[Index(std::min(i, j), std::max(i, j))] =
+        static_cast<float>(similarity);
+  }
+
+  uint32_t GetSentenceSize(size_t i) const { return sentence_sizes[i]; }
+
+  void SetSentenceSize(size_t i, size_t terms) {
+    sentence_sizes[i] = static_cast<uint32_t>(terms);
+  }
+
+  /// <summary>
+  /// same as Embedding::NormalizedSimilarity
+  /// </summary>
+  double NormalizedSimilarity(size_t i, size_t j) const {
+    const auto sim = Get(i, j);
+    return (sim / sentence_sizes[i] + sim / sentence_sizes[j]) / 2;
+  }
+
+private:
+  /// <summary>
+  /// scores before row i. row k holds min(e, size - 1 - k) pairs with
+  /// e = effective band, so rows past s = size - 1 - e are shorter
+  /// </summary>
+  static uint64_t Offset(uint64_t size, uint64_t band, uint64_t i) noexcept {
+    if (size < 2) {
+      return 0;
+    }
+    const auto e = band == 0 ? size - 1 : std::min(band, size - 1);
+    const auto s = size - 1 - e;
+    const auto shorter = i > s ? (i - s) * (i - s - 1) / 2 : 0;
+    return i * e - shorter;
+  }
+
+  size_t Offset(size_t i) const noexcept {
+    return static_cast<size_t>(Offset(size, band, i));
+  }
+
+  size_t Index(size_t i, size_t j) const noexcept {
+    return Offset(i) + (j - i - 1);
+  }
+
+  size_t size = 0;
+  size_t band = 0;
+  uint32_t policy = 0;
+  std::vector<uint32_t> sentence_sizes;
+  std::vector<float> scores;
+};
+} // namespace GraphSeg::internal
+
+#endif
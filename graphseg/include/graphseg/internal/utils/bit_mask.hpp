@@ -0,0 +1,181 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_BIT_MASK_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_BIT_MASK_HPP
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace GraphSeg::internal::utils {
+/// <summary>
+/// Set of at most 64 Words small integers held in place, one bit each.
+/// Set operations are a few word instructions, and nothing is allocated
+/// </summary>
+template <size_t Words> class BitMask {
+public:
+  static_assert(Words > 0, "BitMask needs at least one word");
+
+  static constexpr size_t BITS = 64 * Words;
+
+  constexpr BitMask() = default;
+
+  /// <summary>
+  /// bits [begin, end)
+  /// </summary>
+  static BitMask Range(size_t begin, size_t end) noexcept {
+    assert(begin <= end && end <= BITS);
+    BitMask mask;
+    for (size_t w = 0; w < Words; ++w) {
+      const auto low = w * 64;
+      if (end <= low || begin >= low + 64) {
+        continue;
+      }
+      const auto from = begin > low ? begin - low : 0;
+      const auto to = end < low + 64 ? end - low : 64;
+      const auto upper = to == 64 ? ~uint64_t{0} : (uint64_t{1} << to) - 1;
+      mask.words[w] = upper & ~((uint64_t{1} << from) - 1);
+    }
+    return mask;
+  }
+
+  void Set(size_t i) noexcept {
+    assert(i < BITS);
+    words[i / 64] |= uint64_t{1} << (i % 64);
+  }
+
+  void Reset(size_t i) noexcept {
+    assert(i < BITS);
+    words[i / 64] &= ~(uint64_t{1} << (i % 64));
+  }
+
+  bool Test(size_t i) const noexcept {
+    assert(i < BITS);
+    return (words[i / 64] >> (i % 64)) & 1;
+  }
+
+  bool Any() const noexcept {
+    for (const auto word : words) {
+      if (word != 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  size_t Count() const noexcept {
+    size_t count = 0;
+    for (const auto word : words) {
+      count += static_cast<size_t>(__builtin_popcountll(word));
+    }
+    return count;
+  }
+
+  /// <summary>
+  /// smallest member, BITS if empty
+  /// </summary>
+  size_t Lowest() const noexcept {
+    for (size_t w = 0; w < Words; ++w) {
+      if (words[w] != 0) {
+        return w * 64 + static_cast<size_t>(__builtin_ctzll(words[w]));
+      }
+    }
+    return BITS;
+  }
+
+  /// <summary>
+  /// whether any member is i or larger
+  /// </summary>
+  bool AnyFrom(size_t i) const noexcept {
+    if (i >= BITS) {
+      return false;
+    }
+    if ((words[i / 64] >> (i % 64)) != 0) {
+      return true;
+    }
+    for (auto w = i / 64 + 1; w < Words; ++w) {
+      if (words[w] != 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// <summary>
+  /// call f with each member in ascending order
+  /// </summary>
+  template <class F> void ForEach(F &&f) const {
+    for (size_t w = 0; w < Words; ++w) {
+      for (auto word = words[w]; word != 0; word &= word - 1) {
+        f(w * 64 + static_cast<size_t>(__builtin_ctzll(word)));
+      }
+    }
+  }
+
+  BitMask &operator&=(const BitMask &other) noexcept {
+    for (size_t w = 0; w < Words; ++w) {
+      words[w] &= other.words[w];
+    }
+    return *this;
+  }
+
+  BitMask &operator|=(const BitMask &other) noexcept {
+    for (size_t w = 0; w < Words; ++w) {
+      words[w] |= other.words[w];
+    }
+    return *this;
+  }
+
+  BitMask &operator^=(const BitMask &other) noexcept {
+    for (size_t w = 0; w < Words; ++w) {
+      words[w] ^= other.words[w];
+    }
+    return *this;
+  }
+
+  BitMask operator~() const noexcept {
+    BitMask mask;
+    for (size_t w = 0; w < Words; ++w) {
+      mask.words[w] = ~words[w];
+    }
+    return mask;
+  }
+
+  friend BitMask operator&(BitMask a, const BitMask &b) noexcept {
+    return a &= b;
+  }
+
+  friend BitMask operator|(BitMask a, const BitMask &b) noexcept {
+    return a |= b;
+  }
+
+  friend BitMask operator^(BitMask a, const BitMask &b) noexcept {
+    return a ^= b;
+  }
+
+  friend bool operator==(const BitMask &a, const BitMask &b) noexcept {
+    return a.words == b.words;
+  }
+
+  friend bool operator!=(const BitMask &a, const BitMask &b) noexcept {
+    return !(a == b);
+  }
+
+  /// <summary>
+  /// order of the members as sorted sequences, that of std::set<size_t>
+  /// </summary>
+  friend bool operator<(const BitMask &a, const BitMask &b) noexcept {
+    const auto x = (a ^ b).Lowest();
+    if (x == BITS) {
+      return false;
+    }
+    // up to x both have the same members. the one holding x is smaller
+    // unless the other one ends there
+    return a.Test(x) ? b.AnyFrom(x) : !a.AnyFrom(x);
+  }
+
+private:
+  std::array<uint64_t, Words> words{};
+};
+} // namespace GraphSeg::internal::utils
+
+#endif
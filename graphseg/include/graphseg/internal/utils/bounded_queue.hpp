@@ -0,0 +1,147 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_BOUNDED_QUEUE_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_BOUNDED_QUEUE_HPP
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+
+namespace GraphSeg::internal::utils {
+/// <summary>
+/// Bounded multi-producer multi-consumer queue based on per-cell sequence
+/// numbers. TryPush/TryPop never take a lock, Push/Pop spin and back off while
+/// the queue is full/empty so a slow stage throttles the faster ones.
+/// </summary>
+template <class T> class BoundedQueue {
+  struct Cell {
+    std::atomic<size_t> sequence;
+    std::optional<T> data;
+  };
+
+public:
+  explicit BoundedQueue(size_t capacity)
+      : mask(RoundUp(capacity) - 1), cells(new Cell[mask + 1]) {
+    for (size_t i = 0; i <= mask; ++i) {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  BoundedQueue(const BoundedQueue &) = delete;
+  BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+  /// <summary>
+  /// enqueue without blocking, return false if queue is full
+  /// </summary>
+  bool TryPush(T &&item) {
+    auto pos = enqueue_pos.load(std::memory_order_relaxed);
+    for (;;) {
+      auto &cell = cells[pos & mask];
+      const auto seq = cell.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(seq) -
+                        static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed)) {
+          cell.data.emplace(std::move(item));
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// <summary>
+  /// dequeue without blocking, return std::nullopt if queue is empty
+  /// </summary>
+  std::optional<T> TryPop() {
+    auto pos = dequeue_pos.load(std::memory_order_relaxed);
+    for (;;) {
+      auto &cell = cells[pos & mask];
+      const auto seq = cell.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(seq) -
+                        static_cast<std::ptrdiff_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed)) {
+          std::optional<T> item(std::move(cell.data));
+          cell.data.reset();
+          cell.sequence.store(pos + mask + 1, std::memory_order_release);
+          return item;
+        }
+      } else if (diff < 0) {
+        return std::nullopt;
+      } else {
+        pos = dequeue_pos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// <summary>
+  /// enqueue, wait while queue is full (backpressure)
+  /// </summary>
+  void Push(T &&item) {
+    for (size_t spin = 0; !TryPush(std::move(item)); ++spin) {
+      Backoff(spin);
+    }
+  }
+
+  /// <summary>
+  /// dequeue, wait while queue is empty. return std::nullopt after Close() was
+  /// called and all items were drained
+  /// </summary>
+  std::optional<T> Pop() {
+    for (size_t spin = 0;; ++spin) {
+      if (auto item = TryPop()) {
+        return item;
+      }
+      if (closed.load(std::memory_order_acquire)) {
+        // producers are gone, but one of them may have published just before
+        return TryPop();
+      }
+      Backoff(spin);
+    }
+  }
+
+  /// <summary>
+  /// notify consumers that no more item will be pushed
+  /// </summary>
+  void Close() noexcept { closed.store(true, std::memory_order_release); }
+
+  inline size_t Capacity() const noexcept { return mask + 1; }
+
+private:
+  static size_t RoundUp(size_t n) {
+    size_t capacity = 2;
+    while (capacity < n) {
+      capacity <<= 1;
+    }
+    return capacity;
+  }
+
+  static void Backoff(size_t spin) {
+    if (spin < 64) {
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+
+  const size_t mask;
+  std::unique_ptr<Cell[]> cells;
+
+  // producer and consumer indices live on separate cache lines
+  alignas(64) std::atomic<size_t> enqueue_pos{0};
+  alignas(64) std::atomic<size_t> dequeue_pos{0};
+  alignas(64) std::atomic<bool> closed{false};
+};
+} // namespace GraphSeg::internal::utils
+
+#endif
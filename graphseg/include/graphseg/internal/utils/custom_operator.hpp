@@ -10,7 +10,8 @@
 namespace GraphSeg::internal::utils {
 template <typename T, typename = std::enable_if_t<is_iterable<T>::value> *>
 T operator&(const T &v1, const T &v2) {
-  T result;
+  // result allocates from the same memory resource as its operand
+  T result(v1.get_allocator());
   set_intersection(v1.begin(), v1.end(), v2.begin(), v2.end(),
                    inserter(result, result.end()));
   return result;
@@ -18,7 +19,7 @@ T operator&(const T &v1, const T &v2) {
 
 template <typename T, typename = std::enable_if_t<is_iterable<T>::value> *>
 T operator+(const T &v1, const T &v2) {
-  T result;
+  T result(v1.get_allocator());
   set_union(v1.begin(), v1.end(), v2.begin(), v2.end(),
             inserter(result, result.end()));
   return result;
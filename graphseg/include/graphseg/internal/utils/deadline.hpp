@@ -0,0 +1,59 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_DEADLINE_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_DEADLINE_HPP
+
+#include <chrono>
+#include <cstddef>
+
+namespace GraphSeg::internal::utils {
+/// <summary>
+/// Point in time after which segmentation falls back to cheaper work.
+/// Loops poll Expired() cooperatively; it reads the clock once per
+/// STRIDE polls, so it is cheap enough for inner loops. Once expired it
+/// stays expired. Default constructed deadlines never expire
+/// </summary>
+class Deadline {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr size_t STRIDE = 256;
+
+  Deadline() = default;
+
+  explicit Deadline(Clock::time_point _at) : at(_at), set(true) {}
+
+  bool IsSet() const noexcept { return set; }
+
+  Clock::time_point Get() const noexcept { return at; }
+
+  /// <summary>
+  /// true if the deadline passed, checked every STRIDE calls
+  /// </summary>
+  bool Expired() noexcept {
+    if (!set || expired) {
+      return expired;
+    }
+    if (++polls % STRIDE != 0) {
+      return false;
+    }
+    return Check();
+  }
+
+  /// <summary>
+  /// true if the deadline passed, reads the clock now
+  /// </summary>
+  bool Check() noexcept {
+    if (set && !expired) {
+      expired = Clock::now() >= at;
+    }
+    return expired;
+  }
+
+private:
+  Clock::time_point at{};
+  bool set = false;
+  bool expired = false;
+  size_t polls = 0;
+};
+} // namespace GraphSeg::internal::utils
+
+#endif
@@ -1,30 +1,230 @@
 #ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_EXEC_HPP
 #define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_EXEC_HPP
 
-#include <array>
-#include <cstdio>
+#include <cerrno>
+#include <csignal>
 #include <cstdlib>
-#include <memory>
+#include <cstring>
+#include <exception>
+#include <ctime>
+#include <spawn.h>
+#include <stdexcept>
 #include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+extern char **environ;
 
 namespace GraphSeg::internal::utils {
-static constexpr auto BUFFER_SIZE = 256;
+/// <summary>
+/// Child process whose stdin and stdout are connected to pipes. The command is
+/// executed directly (no shell), stderr is inherited
+/// </summary>
+class Subprocess {
+public:
+  explicit Subprocess(const std::vector<std::string> &args) {
+    int in[2], out[2];
+    if (pipe(in) != 0) {
+      throw std::runtime_error(std::string("pipe: ") + std::strerror(errno));
+    }
+    if (pipe(out) != 0) {
+      close(in[0]);
+      close(in[1]);
+      throw std::runtime_error(std::string("pipe: ") + std::strerror(errno));
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, in[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, out[1], STDOUT_FILENO);
+    for (const auto fd : {in[0], in[1], out[0], out[1]}) {
+      posix_spawn_file_actions_addclose(&actions, fd);
+    }
+
+    std::vector<char *> argv;
+    for (const auto &arg : args) {
+      argv.emplace_back(const_cast<char *>(arg.c_str()));
+    }
+    argv.emplace_back(nullptr);
+
+    const auto code = posix_spawnp(&pid, argv[0], &actions, nullptr,
+                                   argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(in[0]);
+    close(out[1]);
+    if (code != 0) {
+      close(in[1]);
+      close(out[0]);
+      throw std::runtime_error("failed to spawn " + args[0] + ": " +
+                               std::strerror(code));
+    }
+    input_fd = in[1];
+    output_fd = out[0];
+  }
 
-std::string exec(const char *cmd, int &code) {
-  std::string stdout;
-  std::shared_ptr<FILE> pipe(popen(cmd, "r"),
-                             [&](FILE *p) { code = pclose(p); });
-  if (!pipe) {
-    return stdout;
+  Subprocess(const Subprocess &) = delete;
+  Subprocess &operator=(const Subprocess &) = delete;
+
+  ~Subprocess() {
+    CloseInput();
+    CloseOutput();
+    Wait();
+  }
+
+  /// <summary>
+  /// write whole buffer to child's stdin
+  /// </summary>
+  void Write(const void *data, size_t size) {
+    // a dead child must surface as an error, not as SIGPIPE killing us
+    SigpipeGuard guard;
+    auto ptr = static_cast<const char *>(data);
+    while (size > 0) {
+      const auto written = write(input_fd, ptr, size);
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw std::runtime_error(std::string("write to child: ") +
+                                 std::strerror(errno));
+      }
+      ptr += written;
+      size -= static_cast<size_t>(written);
+    }
+  }
+
+  /// <summary>
+  /// read at most size bytes from child's stdout, return 0 on EOF
+  /// </summary>
+  size_t ReadSome(void *data, size_t size) {
+    for (;;) {
+      const auto n = read(output_fd, data, size);
+      if (n >= 0) {
+        return static_cast<size_t>(n);
+      }
+      if (errno != EINTR) {
+        throw std::runtime_error(std::string("read from child: ") +
+                                 std::strerror(errno));
+      }
+    }
   }
-  std::array<char, BUFFER_SIZE> buf;
-  while (!feof(pipe.get())) {
-    if (fgets(buf.data(), buf.size(), pipe.get()) != nullptr) {
-      stdout += buf.data();
+
+  /// <summary>
+  /// read exactly size bytes, return false on premature EOF
+  /// </summary>
+  bool Read(void *data, size_t size) {
+    auto ptr = static_cast<char *>(data);
+    while (size > 0) {
+      const auto n = ReadSome(ptr, size);
+      if (n == 0) {
+        return false;
+      }
+      ptr += n;
+      size -= n;
     }
+    return true;
+  }
+
+  /// <summary>
+  /// send EOF to child
+  /// </summary>
+  void CloseInput() {
+    if (input_fd >= 0) {
+      close(input_fd);
+      input_fd = -1;
+    }
+  }
+
+  /// <summary>
+  /// stop reading child's stdout. child gets EPIPE on further writes
+  /// </summary>
+  void CloseOutput() {
+    if (output_fd >= 0) {
+      close(output_fd);
+      output_fd = -1;
+    }
+  }
+
+  /// <summary>
+  /// wait for child termination and return its exit status
+  /// </summary>
+  int Wait() {
+    if (pid > 0) {
+      while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+      }
+      pid = -1;
+    }
+    return status;
+  }
+
+private:
+  /// <summary>
+  /// block SIGPIPE in current thread and discard the one raised meanwhile
+  /// </summary>
+  class SigpipeGuard {
+  public:
+    SigpipeGuard() {
+      sigemptyset(&sigpipe);
+      sigaddset(&sigpipe, SIGPIPE);
+      pthread_sigmask(SIG_BLOCK, &sigpipe, &previous);
+    }
+
+    ~SigpipeGuard() {
+      sigset_t pending;
+      sigpending(&pending);
+      if (sigismember(&pending, SIGPIPE) == 1) {
+        const timespec zero{0, 0};
+        sigtimedwait(&sigpipe, nullptr, &zero);
+      }
+      pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+    }
+
+  private:
+    sigset_t sigpipe;
+    sigset_t previous;
+  };
+
+  pid_t pid = -1;
+  int status = 0;
+  int input_fd = -1;
+  int output_fd = -1;
+};
+
+/// <summary>
+/// Run command without shell, write input to its stdin and return whole
+/// stdout. input is written from another thread so that large input and
+/// output cannot dead-lock on pipe buffers
+/// </summary>
+inline std::string CaptureCommand(const std::vector<std::string> &args,
+                                  const std::string &input) {
+  Subprocess process(args);
+  std::exception_ptr write_error;
+  std::thread writer([&]() {
+    try {
+      process.Write(input.data(), input.size());
+      process.Write("\n", 1);
+    } catch (...) {
+      write_error = std::current_exception();
+    }
+    process.CloseInput();
+  });
+
+  std::string output;
+  std::vector<char> buffer(64 * 1024);
+  for (;;) {
+    const auto n = process.ReadSome(buffer.data(), buffer.size());
+    if (n == 0) {
+      break;
+    }
+    output.append(buffer.data(), n);
+  }
+  writer.join();
+  if (write_error) {
+    std::rethrow_exception(write_error);
   }
-  return stdout;
+  return output;
 }
 } // namespace GraphSeg::internal::utils
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,33 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_FRAME_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_FRAME_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace GraphSeg::internal::utils {
+/// <summary>
+/// Header of length-prefixed frames used by script/worker.py and
+/// graphseg_server: uint32 opcode (or status) | uint32 payload length,
+/// little-endian
+/// </summary>
+static constexpr size_t FrameHeaderSize = 8;
+
+using FrameHeader = std::array<unsigned char, FrameHeaderSize>;
+
+inline FrameHeader EncodeFrameHeader(uint32_t first, uint32_t second) {
+  FrameHeader header;
+  for (size_t i = 0; i < 4; ++i) {
+    header[i] = static_cast<unsigned char>(first >> (8 * i));
+    header[i + 4] = static_cast<unsigned char>(second >> (8 * i));
+  }
+  return header;
+}
+
+inline uint32_t DecodeUint32(const unsigned char *p) {
+  return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+         static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+} // namespace GraphSeg::internal::utils
+
+#endif
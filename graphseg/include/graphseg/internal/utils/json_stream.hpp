@@ -0,0 +1,121 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_JSON_STREAM_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_JSON_STREAM_HPP
+
+#include "graphseg/internal/utils/exec.hpp"
+
+#include <cassert>
+#include <exception>
+#include <rapidjson/reader.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace GraphSeg::internal::utils {
+static constexpr size_t STREAM_BUFFER_SIZE = 64 * 1024;
+
+/// <summary>
+/// rapidjson input stream reading child's stdout in large chunks
+/// </summary>
+class SubprocessReadStream {
+public:
+  typedef char Ch;
+
+  explicit SubprocessReadStream(Subprocess &_process)
+      : process(_process), buffer(STREAM_BUFFER_SIZE) {
+    Fill();
+  }
+
+  Ch Peek() const { return current < last ? *current : '\0'; }
+
+  Ch Take() {
+    const auto c = Peek();
+    if (current < last) {
+      ++current;
+      ++count;
+      if (current == last) {
+        Fill();
+      }
+    }
+    return c;
+  }
+
+  size_t Tell() const { return count; }
+
+  // write operations are only used by in-situ parsing
+  Ch *PutBegin() {
+    assert(false);
+    return nullptr;
+  }
+  void Put(Ch) { assert(false); }
+  void Flush() { assert(false); }
+  size_t PutEnd(Ch *) {
+    assert(false);
+    return 0;
+  }
+
+private:
+  void Fill() {
+    const auto n = process.ReadSome(buffer.data(), buffer.size());
+    current = buffer.data();
+    last = current + n;
+  }
+
+  Subprocess &process;
+  std::vector<Ch> buffer;
+  const Ch *current = nullptr;
+  const Ch *last = nullptr;
+  size_t count = 0;
+};
+
+/// <summary>
+/// Run command without shell. input is written to its stdin from another
+/// thread while stdout is parsed by SAX handler as it arrives, so neither the
+/// input nor the output is limited by pipe or argument size
+/// </summary>
+template <class Handler>
+void StreamCommand(const std::vector<std::string> &args,
+                   const std::string &input, Handler &handler) {
+  Subprocess process(args);
+  std::exception_ptr write_error;
+  std::thread writer([&]() {
+    try {
+      process.Write(input.data(), input.size());
+      process.Write("\n", 1);
+    } catch (...) {
+      write_error = std::current_exception();
+    }
+    process.CloseInput();
+  });
+
+  SubprocessReadStream stream(process);
+  rapidjson::Reader reader;
+  const auto result = reader.Parse<rapidjson::kParseDefaultFlags>(stream, handler);
+  // unblock child (and writer) if parsing stopped before EOF
+  process.CloseOutput();
+  writer.join();
+
+  if (write_error) {
+    std::rethrow_exception(write_error);
+  }
+  if (result.IsError()) {
+    throw std::runtime_error("failed to parse output of " + args.back());
+  }
+}
+
+/// <summary>
+/// Parse JSON held in buffer with SAX handler. buffer is modified in-situ,
+/// strings passed to handler point into it
+/// </summary>
+template <class Handler> void ParseInsitu(std::string &buffer, Handler &handler) {
+  rapidjson::InsituStringStream stream(buffer.data());
+  rapidjson::Reader reader;
+  const auto result =
+      reader.Parse<rapidjson::kParseInsituFlag>(stream, handler);
+  if (result.IsError()) {
+    throw std::runtime_error("failed to parse json");
+  }
+}
+} // namespace GraphSeg::internal::utils
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_MAPPED_FILE_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_MAPPED_FILE_HPP
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace GraphSeg::internal::utils {
+/// <summary>
+/// read-only memory mapped file
+/// </summary>
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error(path + ": " + std::strerror(errno));
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      close(fd);
+      throw std::runtime_error(path + ": " + std::strerror(errno));
+    }
+    length = static_cast<size_t>(st.st_size);
+    if (length != 0) {
+      auto addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error(path + ": " + std::strerror(errno));
+      }
+      mapped = static_cast<const char *>(addr);
+    }
+    close(fd);
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  ~MappedFile() {
+    if (mapped != nullptr) {
+      munmap(const_cast<char *>(mapped), length);
+    }
+  }
+
+  const char *Data() const noexcept { return mapped; }
+
+  size_t Size() const noexcept { return length; }
+
+private:
+  const char *mapped = nullptr;
+  size_t length = 0;
+};
+} // namespace GraphSeg::internal::utils
+
+#endif
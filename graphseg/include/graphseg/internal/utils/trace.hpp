@@ -0,0 +1,229 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_TRACE_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Scoped trace events are recorded only when GRAPHSEG_TRACE is defined.
+/// Otherwise the macros expand to nothing
+/// </summary>
+#define GRAPHSEG_TRACE_CONCAT_IMPL(a, b) a##b
+#define GRAPHSEG_TRACE_CONCAT(a, b) GRAPHSEG_TRACE_CONCAT_IMPL(a, b)
+
+#ifdef GRAPHSEG_TRACE
+#define GRAPHSEG_TRACE_SCOPE(name)                                            \
+  ::GraphSeg::internal::utils::TraceScope GRAPHSEG_TRACE_CONCAT(              \
+      graphseg_trace_scope_, __LINE__)(name)
+#define GRAPHSEG_TRACE_THREAD_NAME(name)                                      \
+  ::GraphSeg::internal::utils::Tracer::Instance().SetThreadName(name)
+#else
+#define GRAPHSEG_TRACE_SCOPE(name)
+#define GRAPHSEG_TRACE_THREAD_NAME(name)
+#endif
+
+#ifndef GRAPHSEG_TRACE_BUFFER_SIZE
+#define GRAPHSEG_TRACE_BUFFER_SIZE 16384
+#endif
+
+namespace GraphSeg::internal::utils {
+/// <summary>
+/// complete event. name must be a string literal
+/// </summary>
+struct TraceEvent {
+  const char *name;
+  uint64_t begin;
+  uint64_t duration;
+};
+
+/// <summary>
+/// Ring buffer written only by its owner thread. Old events are overwritten
+/// once it is full
+/// </summary>
+class TraceBuffer {
+public:
+  static constexpr size_t Capacity = GRAPHSEG_TRACE_BUFFER_SIZE;
+  static_assert((Capacity & (Capacity - 1)) == 0,
+                "GRAPHSEG_TRACE_BUFFER_SIZE must be power of 2");
+
+  explicit TraceBuffer(uint32_t _tid) : tid(_tid), events(Capacity) {}
+
+  void Record(const char *name, uint64_t begin, uint64_t duration) {
+    const auto idx = head.load(std::memory_order_relaxed);
+    events[idx & (Capacity - 1)] = TraceEvent{name, begin, duration};
+    head.store(idx + 1, std::memory_order_release);
+  }
+
+  /// <summary>
+  /// visit retained events, oldest first
+  /// </summary>
+  template <class F> void ForEach(F &&f) const {
+    const auto end = head.load(std::memory_order_acquire);
+    const auto begin = end > Capacity ? end - Capacity : 0;
+    for (auto idx = begin; idx < end; ++idx) {
+      f(events[idx & (Capacity - 1)]);
+    }
+  }
+
+  void Clear() { head.store(0, std::memory_order_release); }
+
+  uint32_t GetThreadId() const noexcept { return tid; }
+
+private:
+  friend class Tracer;
+
+  uint32_t tid;
+  std::string name;
+  std::atomic<uint64_t> head{0};
+  std::vector<TraceEvent> events;
+};
+
+/// <summary>
+/// Process wide owner of per-thread buffers. Recording never locks: a thread
+/// registers its buffer once, on its first event. Buffers outlive their
+/// threads so that events of finished workers can still be dumped
+/// </summary>
+class Tracer {
+public:
+  static Tracer &Instance() {
+    static Tracer tracer;
+    return tracer;
+  }
+
+  /// <summary>
+  /// nanoseconds since tracer start
+  /// </summary>
+  uint64_t Now() const {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - origin)
+            .count());
+  }
+
+  TraceBuffer &LocalBuffer() {
+    thread_local TraceBuffer *buffer = Register();
+    return *buffer;
+  }
+
+  /// <summary>
+  /// label of current thread in trace viewer
+  /// </summary>
+  void SetThreadName(const std::string &name) {
+    auto &buffer = LocalBuffer();
+    std::lock_guard<std::mutex> lock(mtx);
+    buffer.name = name;
+  }
+
+  /// <summary>
+  /// drop recorded events. threads must not be recording meanwhile
+  /// </summary>
+  void Clear() {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (auto &buffer : buffers) {
+      buffer->Clear();
+    }
+  }
+
+  /// <summary>
+  /// write events as Chrome trace JSON, readable by chrome://tracing and
+  /// Perfetto. call after traced work has finished, events being recorded
+  /// concurrently may be torn
+  /// </summary>
+  void Dump(std::ostream &os) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    const auto separator = [&]() {
+      if (!first) {
+        os << ",\n";
+      }
+      first = false;
+    };
+    char number[64];
+    for (const auto &buffer : buffers) {
+      if (!buffer->name.empty()) {
+        separator();
+        os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+           << buffer->tid << ",\"args\":{\"name\":";
+        WriteString(os, buffer->name);
+        os << "}}";
+      }
+      buffer->ForEach([&](const TraceEvent &event) {
+        separator();
+        os << "{\"name\":";
+        WriteString(os, event.name);
+        std::snprintf(number, sizeof(number),
+                      ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f",
+                      static_cast<double>(event.begin) / 1e3,
+                      static_cast<double>(event.duration) / 1e3);
+        os << number << ",\"pid\":1,\"tid\":" << buffer->tid << "}";
+      });
+    }
+    os << "]}\n";
+  }
+
+  void Dump(const std::string &path) const {
+    std::ofstream ofs(path);
+    Dump(ofs);
+  }
+
+private:
+  Tracer() : origin(std::chrono::steady_clock::now()) {}
+
+  TraceBuffer *Register() {
+    std::lock_guard<std::mutex> lock(mtx);
+    buffers.emplace_back(std::make_unique<TraceBuffer>(
+        static_cast<uint32_t>(buffers.size() + 1)));
+    return buffers.back().get();
+  }
+
+  static void WriteString(std::ostream &os, const std::string &s) {
+    os << '"';
+    for (const auto c : s) {
+      if (c == '"' || c == '\\') {
+        os << '\\' << c;
+      } else if (static_cast<unsigned char>(c) < 0x20) {
+        os << ' ';
+      } else {
+        os << c;
+      }
+    }
+    os << '"';
+  }
+
+  std::chrono::steady_clock::time_point origin;
+  mutable std::mutex mtx;
+  std::vector<std::unique_ptr<TraceBuffer>> buffers;
+};
+
+/// <summary>
+/// record lifetime of scope as one event of current thread
+/// </summary>
+class TraceScope {
+public:
+  explicit TraceScope(const char *_name)
+      : name(_name), begin(Tracer::Instance().Now()) {}
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+  ~TraceScope() {
+    auto &tracer = Tracer::Instance();
+    tracer.LocalBuffer().Record(name, begin, tracer.Now() - begin);
+  }
+
+private:
+  const char *name;
+  uint64_t begin;
+};
+} // namespace GraphSeg::internal::utils
+
+#endif
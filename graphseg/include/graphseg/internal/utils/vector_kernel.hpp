@@ -0,0 +1,100 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_VECTOR_KERNEL_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_VECTOR_KERNEL_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+namespace GraphSeg::internal::utils {
+/// <summary>
+/// dot product of two length-Dim vectors, fully unrolled at compile time.
+/// four independent accumulators keep the adds off one dependency chain
+/// </summary>
+template <size_t... I>
+inline double DotUnrolled(const double *a, const double *b,
+                          std::index_sequence<I...>) {
+  double acc[4] = {0.0, 0.0, 0.0, 0.0};
+  ((acc[I % 4] += a[I] * b[I]), ...);
+  return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+template <size_t Dim> inline double Dot(const double *a, const double *b) {
+  return DotUnrolled(a, b, std::make_index_sequence<Dim>());
+}
+
+/// <summary>
+/// dot product of any length, vectorized by the compiler (-fopenmp-simd)
+/// </summary>
+inline double Dot(const double *a, const double *b, size_t dim) {
+  double sum = 0.0;
+#pragma omp simd reduction(+ : sum)
+  for (size_t i = 0; i < dim; ++i) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+using DotKernel = double (*)(const double *, const double *, size_t);
+
+template <size_t Dim>
+double DotFixed(const double *a, const double *b, size_t) {
+  return Dot<Dim>(a, b);
+}
+
+/// <summary>
+/// unrolled kernel for dimensions of common models, generic loop otherwise
+/// </summary>
+inline DotKernel SelectDotKernel(size_t dim) {
+  switch (dim) {
+  case 50:
+    return DotFixed<50>;
+  case 100:
+    return DotFixed<100>;
+  case 200:
+    return DotFixed<200>;
+  case 300:
+    return DotFixed<300>;
+  default:
+    return static_cast<DotKernel>(Dot);
+  }
+}
+
+inline double Norm(const double *a, size_t dim) {
+  return std::sqrt(Dot(a, a, dim));
+}
+
+/// <summary>
+/// y += alpha * x
+/// </summary>
+inline void Axpy(double alpha, const double *x, double *y, size_t dim) {
+#pragma omp simd
+  for (size_t i = 0; i < dim; ++i) {
+    y[i] += alpha * x[i];
+  }
+}
+
+/// <summary>
+/// Upper triangle of A * A^T for n row-major rows of dim values:
+/// out[i * n + j] = a_i . a_j for i < j, the rest is left untouched.
+/// Rows are taken in tiles small enough that two tiles stay in L2 while
+/// every pair between them is formed
+/// </summary>
+inline void GramUpper(const double *a, size_t n, size_t dim, double *out,
+                      DotKernel dot) {
+  const size_t tile = std::max<size_t>(8, 16384 / std::max<size_t>(dim, 1));
+  for (size_t ib = 0; ib < n; ib += tile) {
+    const auto ie = std::min(ib + tile, n);
+    for (size_t jb = ib; jb < n; jb += tile) {
+      const auto je = std::min(jb + tile, n);
+      for (size_t i = ib; i < ie; ++i) {
+        for (size_t j = std::max(jb, i + 1); j < je; ++j) {
+          out[i * n + j] = dot(a + i * dim, a + j * dim, dim);
+        }
+      }
+    }
+  }
+}
+} // namespace GraphSeg::internal::utils
+
+#endif
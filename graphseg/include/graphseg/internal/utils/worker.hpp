@@ -0,0 +1,84 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_WORKER_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_UTIL_WORKER_HPP
+
+#include "graphseg/internal/utils/exec.hpp"
+#include "graphseg/internal/utils/frame.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace GraphSeg::internal::utils {
+/// <summary>
+/// request type of script/worker.py
+/// </summary>
+enum class WorkerOpcode : uint32_t {
+  VECTORIZE = 1,
+  FREQUENCY = 2,
+  VECTORIZE_BINARY = 3
+};
+
+/// <summary>
+/// Long-lived python process serving vectorizer.py and frequency.py.
+/// Models are loaded once at start up, so each request costs one round trip
+/// over the pipe. Frames are length-prefixed:
+///   request  : uint32 opcode | uint32 length | terms separated by ' '
+///   response : uint32 status | uint32 length | payload
+/// all integers are little-endian
+/// </summary>
+class ScriptWorker {
+public:
+  ScriptWorker(const std::string &python, const std::string &script,
+               const std::string &lang_dir)
+      : process({python, script, lang_dir}) {}
+
+  /// <summary>
+  /// convert script name used by Executable to request type
+  /// </summary>
+  static WorkerOpcode Opcode(const std::string &script,
+                             bool binary = false) {
+    if (script == "vectorizer.py") {
+      return binary ? WorkerOpcode::VECTORIZE_BINARY
+                    : WorkerOpcode::VECTORIZE;
+    }
+    if (script == "frequency.py") {
+      return WorkerOpcode::FREQUENCY;
+    }
+    throw std::invalid_argument(script + " is not served by worker");
+  }
+
+  /// <summary>
+  /// send one request and wait for its response. requests from several
+  /// threads are serialized
+  /// </summary>
+  std::string Request(WorkerOpcode opcode, const std::string &payload) {
+    std::lock_guard<std::mutex> lock(mtx);
+
+    auto header = EncodeFrameHeader(static_cast<uint32_t>(opcode),
+                                    static_cast<uint32_t>(payload.size()));
+    process.Write(header.data(), header.size());
+    process.Write(payload.data(), payload.size());
+
+    if (!process.Read(header.data(), header.size())) {
+      throw std::runtime_error("worker terminated unexpectedly");
+    }
+    const auto status = DecodeUint32(header.data());
+    std::string body(DecodeUint32(header.data() + 4), '\0');
+    if (!process.Read(body.data(), body.size())) {
+      throw std::runtime_error("worker terminated unexpectedly");
+    }
+    if (status != 0) {
+      throw std::runtime_error("worker error: " + body);
+    }
+    return body;
+  }
+
+private:
+  std::mutex mtx;
+  Subprocess process;
+};
+} // namespace GraphSeg::internal::utils
+
+#endif
@@ -0,0 +1,219 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_VECTOR_FORMAT_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_VECTOR_FORMAT_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace GraphSeg::internal {
+/// <summary>
+/// Binary word vector transport format (all integers little-endian)
+///
+///   header (32 bytes)
+///     char[4]  magic "GSVF"
+///     uint32   version (1)
+///     uint32   dimension
+///     uint32   dtype (0: float32, 1: float16)
+///     uint32   count of terms
+///     uint32   reserved (0)
+///     uint64   byte size of term table
+///   term table
+///     count x (uint32 byte length, UTF-8 bytes)
+///   zero padding up to 8 byte boundary
+///   rows
+///     count x dimension x dtype, little-endian, in term table order
+/// </summary>
+namespace VectorFormat {
+static constexpr char MAGIC[4] = {'G', 'S', 'V', 'F'};
+static constexpr uint32_t VERSION = 1;
+static constexpr size_t HEADER_SIZE = 32;
+
+enum class DataType : uint32_t { FLOAT32 = 0, FLOAT16 = 1 };
+
+inline uint32_t ReadUint32(const char *p) {
+  const auto u = reinterpret_cast<const unsigned char *>(p);
+  return static_cast<uint32_t>(u[0]) | static_cast<uint32_t>(u[1]) << 8 |
+         static_cast<uint32_t>(u[2]) << 16 | static_cast<uint32_t>(u[3]) << 24;
+}
+
+inline uint64_t ReadUint64(const char *p) {
+  return static_cast<uint64_t>(ReadUint32(p)) |
+         static_cast<uint64_t>(ReadUint32(p + 4)) << 32;
+}
+
+inline void WriteUint32(std::ostream &os, uint32_t v) {
+  char buf[4];
+  for (size_t i = 0; i < 4; ++i) {
+    buf[i] = static_cast<char>(v >> (8 * i));
+  }
+  os.write(buf, 4);
+}
+
+inline void WriteUint64(std::ostream &os, uint64_t v) {
+  WriteUint32(os, static_cast<uint32_t>(v));
+  WriteUint32(os, static_cast<uint32_t>(v >> 32));
+}
+
+inline size_t Align8(size_t n) { return (n + 7) & ~static_cast<size_t>(7); }
+
+inline float HalfToFloat(uint16_t h) {
+  const auto sign = (h & 0x8000) != 0 ? -1.0f : 1.0f;
+  const int exponent = (h >> 10) & 0x1f;
+  const int mantissa = h & 0x3ff;
+  if (exponent == 0) {
+    return sign * std::ldexp(static_cast<float>(mantissa), -24);
+  }
+  if (exponent == 0x1f) {
+    return mantissa == 0 ? sign * INFINITY : NAN;
+  }
+  return sign * std::ldexp(static_cast<float>(mantissa + 0x400), exponent - 25);
+}
+
+/// <summary>
+/// serialize float32 rows (count x dimension, row major)
+/// </summary>
+inline void Write(std::ostream &os, const std::vector<std::string> &terms,
+                  const std::vector<float> &rows, uint32_t dimension) {
+  if (rows.size() != terms.size() * dimension) {
+    throw std::invalid_argument("rows size does not match terms x dimension");
+  }
+  uint64_t table_size = 0;
+  for (const auto &term : terms) {
+    table_size += 4 + term.size();
+  }
+  os.write(MAGIC, 4);
+  WriteUint32(os, VERSION);
+  WriteUint32(os, dimension);
+  WriteUint32(os, static_cast<uint32_t>(DataType::FLOAT32));
+  WriteUint32(os, static_cast<uint32_t>(terms.size()));
+  WriteUint32(os, 0);
+  WriteUint64(os, table_size);
+  for (const auto &term : terms) {
+    WriteUint32(os, static_cast<uint32_t>(term.size()));
+    os.write(term.data(), static_cast<std::streamsize>(term.size()));
+  }
+  const auto padding = Align8(HEADER_SIZE + table_size) - HEADER_SIZE - table_size;
+  os.write("\0\0\0\0\0\0\0", static_cast<std::streamsize>(padding));
+  for (const auto v : rows) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    WriteUint32(os, bits);
+  }
+}
+} // namespace VectorFormat
+
+/// <summary>
+/// Zero-copy reader of VectorFormat buffer. terms and rows point into the
+/// passed buffer, which must outlive the view
+/// </summary>
+class VectorFormatView {
+public:
+  VectorFormatView(const char *_data, size_t _size) : data(_data), size(_size) {
+    if (size < VectorFormat::HEADER_SIZE ||
+        std::memcmp(data, VectorFormat::MAGIC, 4) != 0) {
+      throw std::runtime_error("not a vector format buffer");
+    }
+    if (VectorFormat::ReadUint32(data + 4) != VectorFormat::VERSION) {
+      throw std::runtime_error("unsupported vector format version");
+    }
+    dimension = VectorFormat::ReadUint32(data + 8);
+    dtype = static_cast<VectorFormat::DataType>(VectorFormat::ReadUint32(data + 12));
+    if (dtype != VectorFormat::DataType::FLOAT32 &&
+        dtype != VectorFormat::DataType::FLOAT16) {
+      throw std::runtime_error("unsupported vector data type");
+    }
+    const auto count = VectorFormat::ReadUint32(data + 16);
+    const auto table_size = VectorFormat::ReadUint64(data + 24);
+
+    size_t pos = VectorFormat::HEADER_SIZE;
+    if (table_size > size - pos) {
+      throw std::runtime_error("truncated term table");
+    }
+    const size_t table_end = pos + static_cast<size_t>(table_size);
+    terms.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+      if (pos + 4 > table_end) {
+        throw std::runtime_error("truncated term table");
+      }
+      const auto length = VectorFormat::ReadUint32(data + pos);
+      pos += 4;
+      if (pos + length > table_end) {
+        throw std::runtime_error("truncated term table");
+      }
+      terms.emplace_back(data + pos, length);
+      pos += length;
+    }
+    const auto rows_offset = VectorFormat::Align8(table_end);
+    if (rows_offset > size || RowBytes() * count > size - rows_offset) {
+      throw std::runtime_error("truncated vector rows");
+    }
+    rows = data + rows_offset;
+  }
+
+  /// <summary>
+  /// vector dimension
+  /// </summary>
+  size_t Dimension() const noexcept { return dimension; }
+
+  /// <summary>
+  /// number of terms
+  /// </summary>
+  size_t Size() const noexcept { return terms.size(); }
+
+  const std::string_view &Term(size_t idx) const { return terms[idx]; }
+
+  /// <summary>
+  /// convert idx-th row into out[0, Dimension())
+  /// </summary>
+  template <class T> void CopyRow(size_t idx, T *out) const {
+    const char *row = rows + RowBytes() * idx;
+    if (dtype == VectorFormat::DataType::FLOAT32) {
+      for (size_t i = 0; i < dimension; ++i) {
+        const auto bits = VectorFormat::ReadUint32(row + 4 * i);
+        float v;
+        std::memcpy(&v, &bits, sizeof(v));
+        out[i] = static_cast<T>(v);
+      }
+    } else {
+      const auto u = reinterpret_cast<const unsigned char *>(row);
+      for (size_t i = 0; i < dimension; ++i) {
+        const auto bits = static_cast<uint16_t>(u[2 * i] | u[2 * i + 1] << 8);
+        out[i] = static_cast<T>(VectorFormat::HalfToFloat(bits));
+      }
+    }
+  }
+
+  /// <summary>
+  /// build term -> row index map
+  /// </summary>
+  std::unordered_map<std::string_view, size_t> BuildIndex() const {
+    std::unordered_map<std::string_view, size_t> index;
+    index.reserve(terms.size());
+    for (size_t i = 0; i < terms.size(); ++i) {
+      index.emplace(terms[i], i);
+    }
+    return index;
+  }
+
+private:
+  size_t RowBytes() const {
+    return dimension *
+           (dtype == VectorFormat::DataType::FLOAT32 ? sizeof(float) : 2);
+  }
+
+  const char *data;
+  size_t size;
+  size_t dimension;
+  VectorFormat::DataType dtype;
+  std::vector<std::string_view> terms;
+  const char *rows;
+};
+} // namespace GraphSeg::internal
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_INTERNAL_VECTOR_STORE_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_INTERNAL_VECTOR_STORE_HPP
+
+#include "graphseg/internal/utils/mapped_file.hpp"
+#include "graphseg/internal/vector_format.hpp"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace GraphSeg::internal {
+/// <summary>
+/// Whole embedding model in VectorFormat, mapped once and indexed by term.
+/// Long-running processes share one store between all documents instead of
+/// asking vectorizer.py for every document
+/// </summary>
+class VectorStore {
+public:
+  explicit VectorStore(const std::string &path)
+      : file(path), view(file.Data(), file.Size()), index(view.BuildIndex()) {}
+
+  VectorStore(const VectorStore &) = delete;
+  VectorStore &operator=(const VectorStore &) = delete;
+
+  size_t Dimension() const noexcept { return view.Dimension(); }
+
+  size_t Size() const noexcept { return view.Size(); }
+
+  /// <summary>
+  /// row index of term, nullopt if out of vocabulary
+  /// </summary>
+  std::optional<size_t> Find(std::string_view term) const {
+    const auto itr = index.find(term);
+    if (itr == index.end()) {
+      return std::nullopt;
+    }
+    return itr->second;
+  }
+
+  template <class T> void CopyRow(size_t idx, T *out) const {
+    view.CopyRow(idx, out);
+  }
+
+private:
+  utils::MappedFile file;
+  VectorFormatView view;
+  std::unordered_map<std::string_view, size_t> index;
+};
+} // namespace GraphSeg::internal
+
+#endif
@@ -1,12 +1,16 @@
 #ifndef GRAPHSEG_CPP_GRAPHSEG_LANG_HPP
 #define GRAPHSEG_CPP_GRAPHSEG_LANG_HPP
 
-#include "graphseg/internal/utils/exec.hpp"
+#include "graphseg/internal/utils/json_stream.hpp"
 #include "graphseg/internal/utils/mecab_helper.hpp"
+#include "graphseg/internal/utils/trace.hpp"
+#include "graphseg/internal/utils/worker.hpp"
 
+#include <atomic>
 #include <filesystem>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <mecab.h>
 #include <string>
 #include <type_traits>
@@ -23,8 +27,11 @@ protected:
   }
 
   static const std::string SentenceTagger(const std::string &s) {
+    GRAPHSEG_TRACE_SCOPE("SentenceTagger");
     if constexpr (LangType == Lang::JP) {
-      const auto tagger = MeCab::createTagger("");
+      // creating tagger loads the whole dictionary, so keep one per thread
+      thread_local const std::unique_ptr<MeCab::Tagger> tagger(
+          MeCab::createTagger(""));
       auto parsed_sentence = tagger->parse(s.c_str());
       return GraphSeg::internal::utils::ExtractTerm(parsed_sentence);
     } else {
@@ -44,31 +51,82 @@ class Executable<Lang::JP> // I think that template specialization is better
                            // than if constexpr
 {
 protected:
-  std::string Execute(const std::string &script, const std::string &input) {
+  /// <summary>
+  /// Run script with input on its stdin, and feed its JSON output to SAX
+  /// handler
+  /// </summary>
+  template <class Handler>
+  void Execute(const std::string &script, const std::string &input,
+               Handler &handler) {
     if (!ScriptExistence(ScriptPathExtractor(), script)) {
       std::runtime_error(ScriptPathExtractor() + "/" + script +
                          " doe's not exist");
     }
 
-    int code;
-    const std::string cmd =
-        "echo " + input + " | " + CommandBaseExtractor() + "/" + script;
-    auto result = internal::utils::exec(cmd.c_str(), code);
-    return result;
+    if (auto worker = std::atomic_load(&PersistentWorker())) {
+      auto body = worker->Request(
+          internal::utils::ScriptWorker::Opcode(script), input);
+      internal::utils::ParseInsitu(body, handler);
+      return;
+    }
+
+    internal::utils::StreamCommand(
+        {PythonPathExtractor(), ScriptPathExtractor() + "/" + script}, input,
+        handler);
+  }
+
+  /// <summary>
+  /// Run script with --binary option and return its raw output
+  /// </summary>
+  std::string ExecuteBinary(const std::string &script,
+                            const std::string &input) {
+    if (auto worker = std::atomic_load(&PersistentWorker())) {
+      return worker->Request(
+          internal::utils::ScriptWorker::Opcode(script, true), input);
+    }
+    return internal::utils::CaptureCommand(
+        {PythonPathExtractor(), ScriptPathExtractor() + "/" + script,
+         "--binary"},
+        input);
+  }
+
+public:
+  /// <summary>
+  /// Start long-lived script/worker.py. Following Execute() calls are served
+  /// by it instead of launching python (and loading models) every time
+  /// </summary>
+  static void StartPersistentWorker() {
+    std::atomic_store(&PersistentWorker(),
+                      std::make_shared<internal::utils::ScriptWorker>(
+                          PythonPathExtractor(),
+                          ScriptRootExtractor() + "/worker.py", "jp"));
+  }
+
+  /// <summary>
+  /// Stop persistent worker. in-flight requests finish before it exits
+  /// </summary>
+  static void StopPersistentWorker() {
+    std::atomic_store(&PersistentWorker(),
+                      std::shared_ptr<internal::utils::ScriptWorker>());
   }
 
 private:
-  std::string CommandBaseExtractor() {
-    return PythonPathExtractor() + " " + ScriptPathExtractor();
+  static std::shared_ptr<internal::utils::ScriptWorker> &PersistentWorker() {
+    static std::shared_ptr<internal::utils::ScriptWorker> worker;
+    return worker;
   }
 
-  std::string ScriptPathExtractor() {
+  static std::string ScriptRootExtractor() {
     const std::string scriptPath = getenv("PY_SCRIPT_PATH");
     assert(scriptPath.size() != 0);
-    return scriptPath + "/jp";
+    return scriptPath;
+  }
+
+  std::string ScriptPathExtractor() {
+    return ScriptRootExtractor() + "/jp";
   }
 
-  std::string PythonPathExtractor() {
+  static std::string PythonPathExtractor() {
     const std::string pythonPath = getenv("PYTHON_PATH");
     assert(pythonPath.size() != 0);
     return pythonPath;
@@ -86,31 +144,82 @@ private:
 
 template <> class Executable<Lang::EN> {
 protected:
-  std::string Execute(const std::string &script, const std::string &input) {
+  /// <summary>
+  /// Run script with input on its stdin, and feed its JSON output to SAX
+  /// handler
+  /// </summary>
+  template <class Handler>
+  void Execute(const std::string &script, const std::string &input,
+               Handler &handler) {
     if (!ScriptExistence(ScriptPathExtractor(), script)) {
       std::runtime_error(ScriptPathExtractor() + "/" + script +
                          " doe's not exist");
     }
 
-    int code;
-    const std::string cmd =
-        "echo " + input + " | " + CommandBaseExtractor() + "/" + script;
-    auto result = internal::utils::exec(cmd.c_str(), code);
-    return result;
+    if (auto worker = std::atomic_load(&PersistentWorker())) {
+      auto body = worker->Request(
+          internal::utils::ScriptWorker::Opcode(script), input);
+      internal::utils::ParseInsitu(body, handler);
+      return;
+    }
+
+    internal::utils::StreamCommand(
+        {PythonPathExtractor(), ScriptPathExtractor() + "/" + script}, input,
+        handler);
+  }
+
+  /// <summary>
+  /// Run script with --binary option and return its raw output
+  /// </summary>
+  std::string ExecuteBinary(const std::string &script,
+                            const std::string &input) {
+    if (auto worker = std::atomic_load(&PersistentWorker())) {
+      return worker->Request(
+          internal::utils::ScriptWorker::Opcode(script, true), input);
+    }
+    return internal::utils::CaptureCommand(
+        {PythonPathExtractor(), ScriptPathExtractor() + "/" + script,
+         "--binary"},
+        input);
+  }
+
+public:
+  /// <summary>
+  /// Start long-lived script/worker.py. Following Execute() calls are served
+  /// by it instead of launching python (and loading models) every time
+  /// </summary>
+  static void StartPersistentWorker() {
+    std::atomic_store(&PersistentWorker(),
+                      std::make_shared<internal::utils::ScriptWorker>(
+                          PythonPathExtractor(),
+                          ScriptRootExtractor() + "/worker.py", "en"));
+  }
+
+  /// <summary>
+  /// Stop persistent worker. in-flight requests finish before it exits
+  /// </summary>
+  static void StopPersistentWorker() {
+    std::atomic_store(&PersistentWorker(),
+                      std::shared_ptr<internal::utils::ScriptWorker>());
   }
 
 private:
-  std::string CommandBaseExtractor() {
-    return PythonPathExtractor() + " " + ScriptPathExtractor();
+  static std::shared_ptr<internal::utils::ScriptWorker> &PersistentWorker() {
+    static std::shared_ptr<internal::utils::ScriptWorker> worker;
+    return worker;
   }
 
-  std::string ScriptPathExtractor() {
+  static std::string ScriptRootExtractor() {
     const std::string scriptPath = getenv("PY_SCRIPT_PATH");
     assert(scriptPath.size() != 0);
-    return scriptPath + "/en";
+    return scriptPath;
+  }
+
+  std::string ScriptPathExtractor() {
+    return ScriptRootExtractor() + "/en";
   }
 
-  std::string PythonPathExtractor() {
+  static std::string PythonPathExtractor() {
     const std::string pythonPath = getenv("PYTHON_PATH");
     assert(pythonPath.size() != 0);
     return pythonPath;
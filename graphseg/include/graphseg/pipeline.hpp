@@ -0,0 +1,422 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_PIPELINE_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_PIPELINE_HPP
+
+#include "graphseg/document_segmenter.hpp"
+#include "graphseg/embedding.hpp"
+#include "graphseg/internal/segment_cache.hpp"
+#include "graphseg/internal/utils/bounded_queue.hpp"
+#include "graphseg/internal/utils/trace.hpp"
+#include "graphseg/language.hpp"
+#include "graphseg/segmentation_container.hpp"
+#include "graphseg/text.hpp"
+#include "graphseg/text_factory.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace GraphSeg {
+/// <summary>
+/// pipeline stages. every stage runs on its own worker group
+/// </summary>
+enum class PipelineStage { READ, TAG, EMBED, SEGMENT };
+
+static constexpr size_t PipelineStageSize = 4;
+
+inline const char *PipelineStageName(PipelineStage stage) {
+  static constexpr const char *names[PipelineStageSize] = {"READ", "TAG",
+                                                           "EMBED", "SEGMENT"};
+  return names[static_cast<size_t>(stage)];
+}
+
+/// <summary>
+/// settings of documents are those of SegmenterConfig
+/// </summary>
+struct PipelineConfig : SegmenterConfig {
+  /// <summary>
+  /// worker count of each stage (indexed by PipelineStage)
+  /// </summary>
+  std::array<size_t, PipelineStageSize> workers{1, 1, 1, 1};
+
+  /// <summary>
+  /// capacity of queues connecting stages
+  /// </summary>
+  size_t queue_capacity = 16;
+
+  /// <summary>
+  /// save pairwise sentence scores of every document to
+  /// <similarity_dir>/<id>.gssm for graphseg_sweep, empty to skip.
+  /// segments are the same either way
+  /// </summary>
+  std::string similarity_dir;
+
+  /// <summary>
+  /// saved scores of pairs farther apart than this are left out (0: all
+  /// pairs)
+  /// </summary>
+  size_t similarity_band = 0;
+};
+
+/// <summary>
+/// snapshot of per-stage throughput counters
+/// </summary>
+struct PipelineStageStats {
+  uint64_t processed = 0;
+
+  /// <summary>
+  /// time spent doing actual work (summed over workers)
+  /// </summary>
+  std::chrono::nanoseconds busy{0};
+
+  /// <summary>
+  /// time spent waiting for the upstream stage
+  /// </summary>
+  std::chrono::nanoseconds starved{0};
+
+  /// <summary>
+  /// time spent waiting for the downstream stage (backpressure)
+  /// </summary>
+  std::chrono::nanoseconds blocked{0};
+
+  /// <summary>
+  /// documents per second of busy time per worker
+  /// </summary>
+  double Throughput(size_t workers) const {
+    if (busy.count() == 0) {
+      return 0.0;
+    }
+    return static_cast<double>(processed) * static_cast<double>(workers) /
+           std::chrono::duration<double>(busy).count();
+  }
+};
+
+template <class Graph, int VectorDim, Lang LangType = Lang::EN,
+          class SimilarityPolicy = TermPairSimilarity>
+class Pipeline : public Language<LangType> {
+  using Base = Language<LangType>;
+
+public:
+  using TextType = Text<LangType>;
+  using EmbeddingType = Embedding<VectorDim, LangType>;
+  using Segmenter =
+      DocumentSegmenter<Graph, VectorDim, LangType, SimilarityPolicy>;
+  using Container = typename Segmenter::Container;
+
+  /// <summary>
+  /// document flowing through stages
+  /// </summary>
+  struct Document {
+    size_t id;
+    std::string path;
+    std::wstring raw;
+    std::optional<TextType> text;
+    /// <summary>
+    /// frozen after EMBED, shared with the container instead of copied
+    /// </summary>
+    std::shared_ptr<const EmbeddingType> embedding;
+    size_t sentences = 0;
+    std::vector<std::vector<internal::Vertex>> segments;
+    SegmentationStats stats;
+
+    /// <summary>
+    /// set in READ if PipelineConfig::deadline is
+    /// </summary>
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+
+    /// <summary>
+    /// segments were cut short by the deadline; not cached
+    /// </summary>
+    bool degraded = false;
+
+    /// <summary>
+    /// answered from cache after READ, later stages skip the document
+    /// </summary>
+    bool cached = false;
+
+    /// <summary>
+    /// key to store the result under, set on cache miss
+    /// </summary>
+    std::optional<internal::SegmentCacheKey> cache_key;
+
+    /// <summary>
+    /// set when a stage failed, later stages skip the document
+    /// </summary>
+    std::string error;
+  };
+
+  using Callback = std::function<void(Document &&)>;
+
+  explicit Pipeline(PipelineConfig _config)
+      : config(std::move(_config)), segmenter(config) {}
+
+  /// <summary>
+  /// segment all documents. callback is invoked from SEGMENT workers, so it
+  /// must be thread safe if more than one SEGMENT worker is configured.
+  /// failed documents are passed to callback as well, with error set
+  /// </summary>
+  void Execute(const std::vector<std::string> &paths, Callback callback) {
+    for (auto &counter : counters) {
+      counter.Reset();
+    }
+    const auto begin = std::chrono::steady_clock::now();
+
+    std::array<std::unique_ptr<Queue>, PipelineStageSize> queues;
+    for (auto &queue : queues) {
+      queue = std::make_unique<Queue>(config.queue_capacity);
+    }
+
+    std::array<std::vector<std::thread>, PipelineStageSize> workers;
+    workers[Index(PipelineStage::READ)] =
+        Spawn(PipelineStage::READ, [&] { Read(*queues[0], *queues[1]); });
+    workers[Index(PipelineStage::TAG)] =
+        Spawn(PipelineStage::TAG, [&] { Tag(*queues[1], *queues[2]); });
+    workers[Index(PipelineStage::EMBED)] =
+        Spawn(PipelineStage::EMBED, [&] { Embed(*queues[2], *queues[3]); });
+    workers[Index(PipelineStage::SEGMENT)] = Spawn(
+        PipelineStage::SEGMENT, [&] { Segment(*queues[3], callback); });
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+      auto document = std::make_unique<Document>();
+      document->id = i;
+      document->path = paths[i];
+      queues[0]->Push(std::move(document));
+    }
+
+    // shutdown stage by stage so that every queue is drained
+    for (size_t stage = 0; stage < PipelineStageSize; ++stage) {
+      queues[stage]->Close();
+      for (auto &worker : workers[stage]) {
+        worker.join();
+      }
+    }
+    elapsed = std::chrono::steady_clock::now() - begin;
+  }
+
+  /// <summary>
+  /// get counters of specified stage collected at last Execute()
+  /// </summary>
+  PipelineStageStats GetStageStats(PipelineStage stage) const {
+    return counters[Index(stage)].Snapshot();
+  }
+
+  /// <summary>
+  /// stage with the largest busy time per worker
+  /// </summary>
+  PipelineStage GetBottleneck() const {
+    size_t bottleneck = 0;
+    double max_busy = 0.0;
+    for (size_t i = 0; i < PipelineStageSize; ++i) {
+      const auto busy =
+          static_cast<double>(counters[i].busy.load()) /
+          static_cast<double>(std::max<size_t>(config.workers[i], 1));
+      if (busy > max_busy) {
+        max_busy = busy;
+        bottleneck = i;
+      }
+    }
+    return static_cast<PipelineStage>(bottleneck);
+  }
+
+  /// <summary>
+  /// wall time of last Execute()
+  /// </summary>
+  GRAPHSEG_INLINE_CONST std::chrono::nanoseconds &GetElapsedTime() const {
+    return elapsed;
+  }
+
+  GRAPHSEG_INLINE_CONST PipelineConfig &GetConfig() const { return config; }
+
+private:
+  using Queue = internal::utils::BoundedQueue<std::unique_ptr<Document>>;
+  using Clock = std::chrono::steady_clock;
+
+  struct StageCounter {
+    std::atomic<uint64_t> processed{0};
+    std::atomic<uint64_t> busy{0};
+    std::atomic<uint64_t> starved{0};
+    std::atomic<uint64_t> blocked{0};
+
+    void Reset() {
+      processed = 0;
+      busy = 0;
+      starved = 0;
+      blocked = 0;
+    }
+
+    PipelineStageStats Snapshot() const {
+      PipelineStageStats stats;
+      stats.processed = processed.load();
+      stats.busy = std::chrono::nanoseconds(busy.load());
+      stats.starved = std::chrono::nanoseconds(starved.load());
+      stats.blocked = std::chrono::nanoseconds(blocked.load());
+      return stats;
+    }
+  };
+
+  static constexpr size_t Index(PipelineStage stage) {
+    return static_cast<size_t>(stage);
+  }
+
+  static uint64_t Since(Clock::time_point from) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                             from)
+            .count());
+  }
+
+  template <class F>
+  std::vector<std::thread> Spawn(PipelineStage stage, F &&worker) {
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < std::max<size_t>(config.workers[Index(stage)], 1);
+         ++i) {
+#ifdef GRAPHSEG_TRACE
+      threads.emplace_back([worker, stage, i]() {
+        GRAPHSEG_TRACE_THREAD_NAME(std::string(PipelineStageName(stage)) +
+                                   " #" + std::to_string(i));
+        worker();
+      });
+#else
+      threads.emplace_back(worker);
+#endif
+    }
+    return threads;
+  }
+
+  /// <summary>
+  /// common worker loop: pop from input, process, forward to next stage (or
+  /// to callback in the last stage). exceptions are recorded in the document.
+  /// failed and cached documents are forwarded without processing
+  /// </summary>
+  template <class F, class G>
+  void Run(PipelineStage stage, Queue &input, F &&process, G &&forward) {
+    auto &counter = counters[Index(stage)];
+    for (;;) {
+      const auto waiting = Clock::now();
+      auto document = input.Pop();
+      counter.starved += Since(waiting);
+      if (!document) {
+        break;
+      }
+      const auto working = Clock::now();
+      if ((*document)->error.empty() && !(*document)->cached) {
+        GRAPHSEG_TRACE_SCOPE(PipelineStageName(stage));
+        try {
+          process(**document);
+        } catch (const std::exception &e) {
+          (*document)->error = e.what();
+        }
+      }
+      counter.busy += Since(working);
+      ++counter.processed;
+      const auto blocking = Clock::now();
+      forward(std::move(*document));
+      counter.blocked += Since(blocking);
+    }
+  }
+
+  static auto Forward(Queue &output) {
+    return [&output](std::unique_ptr<Document> &&document) {
+      output.Push(std::move(document));
+    };
+  }
+
+  void Read(Queue &input, Queue &output) {
+    Run(
+        PipelineStage::READ, input,
+        [&](Document &document) {
+          document.deadline = segmenter.Deadline();
+          document.raw = ReadTextFile(document.path, Base::Locale());
+          if (!config.cache) {
+            return;
+          }
+          const auto key = segmenter.MakeKey(document.raw);
+          if (auto hit = config.cache->Find(key)) {
+            document.sentences = hit->sentences;
+            document.segments = std::move(hit->segments);
+            document.cached = true;
+            document.raw.clear();
+          } else {
+            document.cache_key = key;
+          }
+        },
+        Forward(output));
+  }
+
+  void Tag(Queue &input, Queue &output) {
+    Run(
+        PipelineStage::TAG, input,
+        [&](Document &document) {
+          document.text.emplace(document.raw, document.path);
+          document.raw.clear();
+          document.raw.shrink_to_fit();
+        },
+        Forward(output));
+  }
+
+  void Embed(Queue &input, Queue &output) {
+    Run(
+        PipelineStage::EMBED, input,
+        [&](Document &document) {
+          document.embedding = segmenter.Embed(document.text->GetSentences());
+        },
+        Forward(output));
+  }
+
+  void Segment(Queue &input, Callback &callback) {
+    // reused by every document of this worker
+    std::vector<std::byte> scratch(config.arena_size);
+    Run(
+        PipelineStage::SEGMENT, input,
+        [&](Document &document) {
+          const auto &sentences = document.text->GetSentences();
+          document.sentences = sentences.size();
+          // graph, cliques and segments are released at once with arena
+          std::pmr::monotonic_buffer_resource arena(scratch.data(),
+                                                    scratch.size());
+          auto result = segmenter.Segment(
+              sentences, document.embedding, document.deadline, &arena,
+              [&](auto &container) { SaveScores(document, container); });
+          if (document.cache_key) {
+            segmenter.Remember(*document.cache_key, document.sentences,
+                               result);
+          }
+          document.segments = std::move(result.segments);
+          document.stats = result.stats;
+          document.degraded = result.degraded;
+        },
+        [&](std::unique_ptr<Document> &&document) {
+          document->embedding.reset();
+          callback(std::move(*document));
+        });
+  }
+
+  /// <summary>
+  /// scores of the container's scorer, segments never come from them
+  /// </summary>
+  template <class SegmentContainer>
+  void SaveScores(const Document &document, SegmentContainer &container) {
+    if (!config.similarity_dir.empty()) {
+      container.ComputeSimilarityMatrix(config.similarity_band)
+          .Save(config.similarity_dir + "/" + std::to_string(document.id) +
+                ".gssm");
+    }
+  }
+
+  PipelineConfig config;
+  Segmenter segmenter;
+  std::array<StageCounter, PipelineStageSize> counters;
+  std::chrono::nanoseconds elapsed{0};
+};
+} // namespace GraphSeg
+
+#endif
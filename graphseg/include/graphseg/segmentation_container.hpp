@@ -2,10 +2,33 @@
 #define GRAPHSEG_INTERNAL_GRAPHSEG_SEGMENTATION_CONTAINER_HPP
 
 #include "graphseg/embedding.hpp"
+#include "graphseg/graph/bit_graph.hpp"
 #include "graphseg/graph/undirected_graph.hpp"
+#include "graphseg/internal/bit_segmentable.hpp"
+#include "graphseg/internal/coherence_segmentable.hpp"
+#include "graphseg/internal/cost_model.hpp"
+#include "graphseg/internal/segment_engine.hpp"
 #include "graphseg/internal/segmentable.hpp"
+#include "graphseg/internal/segmentation_stats.hpp"
+#include "graphseg/internal/similarity_matrix.hpp"
+#include "graphseg/internal/utils/deadline.hpp"
+#include "graphseg/internal/utils/trace.hpp"
 #include "graphseg/language.hpp"
 #include "graphseg/sentence.hpp"
+#include "graphseg/similarity_policy.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
 
 namespace GraphSeg {
 using namespace graph;
@@ -16,17 +39,34 @@ public:
   /// <summary>
   /// get minimum segment size
   /// </summary>
-  size_t GetMinimumSegmentSize() {
-    assert(segmentable);
-    return segmentable->minimum_segment_size;
+  size_t GetMinimumSegmentSize() const noexcept {
+    return minimum_segment_size;
   }
 
   /// <summary>
-  /// set minumum segmentation size
+  /// set minumum segmentation size, applied by following Segmentation()
   /// </summary>
-  void SetMinimumSegmentSize(size_t s) {
-    assert(segmentable);
-    segmentable->minimum_segment_size = s;
+  void SetMinimumSegmentSize(size_t s) noexcept {
+    minimum_segment_size = s;
+    if (segmentable) {
+      segmentable->minimum_segment_size = s;
+    }
+  }
+
+  /// <summary>
+  /// select how Segmentation() finds segments, applied by following
+  /// SetGraph() and Segmentation()
+  /// </summary>
+  void SetSegmentationEngine(SegmentationEngine e) noexcept { engine = e; }
+
+  SegmentationEngine GetSegmentationEngine() const noexcept { return engine; }
+
+  /// <summary>
+  /// longest segment of SegmentationEngine::COHERENCE, 0 for no limit.
+  /// its time grows with N times this
+  /// </summary>
+  void SetMaximumSegmentLength(size_t length) noexcept {
+    maximum_segment_length = length;
   }
 
   /// <summary>
@@ -42,26 +82,57 @@ public:
     return std::move(segmentable->segments);
   }
 
+  /// <summary>
+  /// copy of segments on the default heap, safe to keep after the memory
+  /// resource of container is released
+  /// </summary>
+  std::vector<std::vector<internal::Vertex>> ExportSegment() const {
+    assert(segmentable);
+    std::vector<std::vector<internal::Vertex>> exported;
+    exported.reserve(segmentable->segments.size());
+    for (const auto &segment : segmentable->segments) {
+      exported.emplace_back(segment.begin(), segment.end());
+    }
+    return exported;
+  }
+
 protected:
   /// <summary>
-  /// entity of segmentation operation
+  /// entity of segmentation operation, Segmentable or CoherenceSegmentable,
+  /// allocated from the memory resource of container like graph
   /// </summary>
-  std::unique_ptr<internal::Segmentable<Graph, VectorDim, LangType>>
-      segmentable;
+  std::shared_ptr<internal::SegmentEngine> segmentable;
+
+  size_t minimum_segment_size = 2;
+  SegmentationEngine engine = SegmentationEngine::CLIQUE;
+  size_t maximum_segment_length = 0;
 };
 
 template <int VectorDim, Lang LangType = Lang::EN> class EmbeddingOperator {
 protected:
-  EmbeddingOperator(const Embedding<VectorDim, LangType> &_embedding)
-      : embedding(_embedding) {}
+  using EmbeddingType = Embedding<VectorDim, LangType>;
+
+  EmbeddingOperator(const EmbeddingType &_embedding)
+      : embedding(std::make_shared<const EmbeddingType>(_embedding)) {}
 
-  EmbeddingOperator(Embedding<VectorDim, LangType> &&_embedding)
-      : embedding(std::move(_embedding)) {}
+  EmbeddingOperator(EmbeddingType &&_embedding)
+      : embedding(
+            std::make_shared<const EmbeddingType>(std::move(_embedding))) {}
+
+  /// <summary>
+  /// shared without copy, only a frozen embedding is safe to share
+  /// </summary>
+  EmbeddingOperator(std::shared_ptr<const EmbeddingType> _embedding)
+      : embedding(std::move(_embedding)) {
+    if (!embedding || !embedding->IsFrozen()) {
+      throw std::invalid_argument("shared embedding must be frozen");
+    }
+  }
 
   /// <summary>
   /// Embedding information extracted from input sentences
   /// </summary>
-  Embedding<VectorDim, LangType> embedding;
+  std::shared_ptr<const EmbeddingType> embedding;
 };
 
 template <class T, class Graph> class GraphOperator {
@@ -70,8 +141,13 @@ public:
   /// Sentence graph instantiation
   /// </summary>
   void SetGraph() {
+    degraded_edges = false;
+    Derived().ClearDegraded();
     SetVertices();
-    SetEdges();
+    if (Derived().UsesEdges()) {
+      Derived().PlanExecution(thereshold);
+      SetEdges();
+    }
   }
 
   /// <summary>
@@ -80,6 +156,46 @@ public:
   /// </summary>
   inline void SetThreshold(double thd) noexcept { thereshold = thd; }
 
+  /// <summary>
+  /// Keep at most edges_per_vertex * |V| edges, the most similar ones.
+  /// Bounds clique enumeration cost on documents where threshold lets the
+  /// graph get dense. 0 disables the limit
+  /// </summary>
+  inline void SetEdgeBudget(double edges_per_vertex) noexcept {
+    edge_budget = edges_per_vertex;
+  }
+
+  /// <summary>
+  /// Score only sentence pairs with j - i <= band, so that edge
+  /// construction takes O(N band) instead of O(N^2) on long documents whose
+  /// edges are between nearby sentences. 0 scores all pairs
+  /// </summary>
+  inline void SetEdgeBand(size_t band) noexcept { edge_band = band; }
+
+  /// <summary>
+  /// Select maximal clique search of the graph (see graph::CliqueMode).
+  /// GREEDY bounds clique search of any graph by |V| ω Δ steps
+  /// </summary>
+  inline void SetCliqueMode(graph::CliqueMode mode) {
+    graph->SetCliqueMode(mode);
+  }
+
+  /// <summary>
+  /// Following edge construction, clique search and segmentation check
+  /// deadline cooperatively and fall back to cheaper work past it instead
+  /// of running late: remaining sentences are paired only with the next
+  /// DEADLINE_EDGE_BAND ones, exact clique search is cut short and
+  /// completed greedily (see UndirectedGraph::SetDeadline), and coherence
+  /// segments are kept short. Call before SetGraph(); IsDegraded() tells
+  /// whether any fallback was taken
+  /// </summary>
+  void SetDeadline(std::chrono::steady_clock::time_point at) {
+    deadline = internal::utils::Deadline(at);
+    degraded_edges = false;
+    graph->SetDeadline(deadline);
+    Derived().ClearDegraded();
+  }
+
   /// <summary>
   /// Get graph (lvalue & rvalue)
   /// </summary>
@@ -103,17 +219,65 @@ private:
   /// Set weight calclated from sentence similarity by word embeddings
   /// </summary>
   void SetEdges() {
+    GRAPHSEG_STATS_ONLY(stats = SegmentationStats();)
+    GRAPHSEG_TRACE_SCOPE("GraphOperator::SetEdges");
+    GRAPHSEG_STATS_PHASE(stats, SegmentationPhase::EDGE);
+    auto candidates = ScoredPairs(thereshold);
+    const auto limit = MaximumEdges();
+    if (candidates.size() > limit) {
+      std::nth_element(candidates.begin(), candidates.begin() + limit,
+                       candidates.end(), std::greater<>());
+      candidates.resize(limit);
+    }
+    for (const auto &[similarity, i, j] : candidates) {
+      graph->SetEdge(i, j, similarity);
+    }
+  }
+
+protected:
+  using ScoredPair = std::tuple<double, int, int>;
+
+  /// <summary>
+  /// edge band of sentences left when the deadline passes
+  /// </summary>
+  static constexpr size_t DEADLINE_EDGE_BAND = 8;
+
+  GraphOperator(std::shared_ptr<Graph> _graph,
+                std::pmr::memory_resource *_resource)
+      : graph(_graph), resource(_resource) {}
+
+  /// <summary>
+  /// sentence pairs (similarity, i, j) with i < j and similarity above thd
+  /// </summary>
+  std::pmr::vector<ScoredPair> ScoredPairs(double thd) {
     const auto graph_size = graph->GetGraphSize();
     assert(graph_size > 1);
-    std::vector<std::vector<int>> memo(graph_size,
-                                       std::vector<int>(graph_size, 0));
+    std::pmr::vector<ScoredPair> candidates(resource);
+    Derived().PrepareScores();
+    // similarity is symmetric, so visit every unordered pair once
+    auto band = edge_band;
     for (int i = 0; i < graph_size; ++i) {
-      for (int j = 0; j < graph_size; ++j) {
-        if ((memo[i][j] == 1 && memo[j][i] == 1) || i == j) {
+      // rows are long enough to read the clock for each
+      if (!degraded_edges && deadline.Check()) {
+        band = band == 0 ? DEADLINE_EDGE_BAND
+                         : std::min(band, DEADLINE_EDGE_BAND);
+        degraded_edges = true;
+      }
+      // pairs beyond the edge band are never connected
+      const auto last = static_cast<int>(
+          band == 0 ? graph_size
+                    : std::min<size_t>(graph_size,
+                                       static_cast<size_t>(i) + band + 1));
+      for (int j = i + 1; j < last; ++j) {
+        if (!Derived().IsScored(i, j)) {
+          continue;
+        }
+        if (!Derived().MayExceed(i, j, thd)) {
+          GRAPHSEG_STATS_ONLY(++stats.pruned_pairs;)
           continue;
         }
-        const auto similarity = Derived().GetEmbedding().GetSimilarity(
-            graph->GetSentence(i), graph->GetSentence(j));
+        const auto similarity = Derived().Similarity(i, j);
+        GRAPHSEG_STATS_ONLY(++stats.similarity_evaluations;)
 #ifdef DEBUG
         std::cout << "sentence 1: " << graph->GetSentence(i).GetText()
                   << std::endl;
@@ -122,67 +286,430 @@ private:
         std::cout << "similarity: " << similarity << std::endl;
         std::cout << "<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<" << std::endl;
 #endif
-        if (similarity > thereshold) {
-          graph->SetEdge(i, j, similarity);
+        if (similarity > thd) {
+          candidates.emplace_back(similarity, i, j);
         }
-        memo[i][j] = 1;
-        memo[j][i] = 1;
       }
     }
+    return candidates;
   }
 
-protected:
-  GraphOperator(std::shared_ptr<Graph> _graph) : graph(_graph) {}
+  /// <summary>
+  /// edges allowed by edge budget
+  /// </summary>
+  size_t MaximumEdges() const noexcept {
+    if (edge_budget <= 0.0) {
+      return std::numeric_limits<size_t>::max();
+    }
+    return static_cast<size_t>(edge_budget *
+                               static_cast<double>(graph->GetGraphSize()));
+  }
 
   /// <summary>
   /// sentence graph
   /// </summary>
   std::shared_ptr<Graph> graph;
 
+  /// <summary>
+  /// backs graph, segments and temporaries. default heap unless the
+  /// caller passes an arena
+  /// </summary>
+  std::pmr::memory_resource *resource;
+
   /// <summary>
   /// thershold whether connect nodes each other
   /// if node similarity is lower than thershold, these are not connected
   /// </summary>
   double thereshold;
+
+  /// <summary>
+  /// maximum edges per vertex, 0 for no limit
+  /// </summary>
+  double edge_budget = 0.0;
+
+  /// <summary>
+  /// largest j - i of scored pairs, 0 for all pairs
+  /// </summary>
+  size_t edge_band = 0;
+
+  /// <summary>
+  /// never expires unless SetDeadline is called. degraded_edges is set
+  /// when rows after it were scored within DEADLINE_EDGE_BAND only
+  /// </summary>
+  internal::utils::Deadline deadline;
+  bool degraded_edges = false;
+
+  /// <summary>
+  /// edge construction time and similarity evaluations
+  /// </summary>
+  SegmentationStats stats;
 };
 
-template <class Graph, int VectorDim, Lang LangType = Lang::EN>
+/// <summary>
+/// SimilarityPolicy scores sentence pairs, TermPairSimilarity or
+/// CentroidSimilarity (see similarity_policy.hpp)
+/// </summary>
+template <class Graph, int VectorDim, Lang LangType = Lang::EN,
+          class SimilarityPolicy = TermPairSimilarity>
 class SegmentationContainer
     : public SegmentOperator<Graph, VectorDim, LangType>,
       public EmbeddingOperator<VectorDim, LangType>,
-      public GraphOperator<SegmentationContainer<Graph, VectorDim, LangType>,
+      public GraphOperator<SegmentationContainer<Graph, VectorDim, LangType,
+                                                 SimilarityPolicy>,
                            Graph> {
   using SegmentOpr = SegmentOperator<Graph, VectorDim, LangType>;
   using GraphOpr =
-      GraphOperator<SegmentationContainer<Graph, VectorDim, LangType>, Graph>;
+      GraphOperator<SegmentationContainer<Graph, VectorDim, LangType,
+                                          SimilarityPolicy>,
+                    Graph>;
   using EmbeddingOpr = EmbeddingOperator<VectorDim, LangType>;
   using SentenceType = Sentence<LangType>;
+  using Scorer =
+      typename SimilarityPolicy::template Scorer<VectorDim, LangType>;
 
 public:
-  SegmentationContainer(const std::vector<SentenceType> &sentences,
-                        const Embedding<VectorDim, LangType> &em)
-      : GraphOpr(std::make_shared<Graph>(sentences)), EmbeddingOpr(em) {}
+  /// <summary>
+  /// graph, cliques and segments are allocated from resource. with a
+  /// std::pmr::monotonic_buffer_resource per document, nothing is freed
+  /// until the document is done; resource must outlive the container.
+  /// use ExportSegment() to keep segments beyond that
+  /// </summary>
+  SegmentationContainer(
+      const std::vector<SentenceType> &sentences,
+      const Embedding<VectorDim, LangType> &em,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : EmbeddingOpr(em), GraphOpr(MakeGraph(sentences, resource), resource) {
+  }
+
+  SegmentationContainer(
+      std::vector<SentenceType> &&sentences,
+      const Embedding<VectorDim, LangType> &em,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : EmbeddingOpr(em),
+        GraphOpr(MakeGraph(std::move(sentences), resource), resource) {}
+
+  /// <summary>
+  /// share frozen embedding (Embedding::Freeze) with other containers,
+  /// e.g. one per thread, instead of copying it
+  /// </summary>
+  SegmentationContainer(
+      const std::vector<SentenceType> &sentences,
+      std::shared_ptr<const Embedding<VectorDim, LangType>> em,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : EmbeddingOpr(std::move(em)),
+        GraphOpr(MakeGraph(sentences, resource), resource) {}
+
+  SegmentationContainer(
+      std::vector<SentenceType> &&sentences,
+      std::shared_ptr<const Embedding<VectorDim, LangType>> em,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : EmbeddingOpr(std::move(em)),
+        GraphOpr(MakeGraph(std::move(sentences), resource), resource) {}
+
+  /// <summary>
+  /// graph from precomputed scores (see ComputeSimilarityMatrix), no
+  /// sentences or embedding needed. pairs outside of its band are never
+  /// connected. throws std::invalid_argument for scores of another
+  /// SimilarityPolicy
+  /// </summary>
+  explicit SegmentationContainer(
+      std::shared_ptr<const internal::SimilarityMatrix> _matrix,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : EmbeddingOpr(Embedding<VectorDim, LangType>()),
+        GraphOpr(MakeGraph(std::vector<SentenceType>(_matrix->Size(),
+                                                     SentenceType("")),
+                           resource),
+                 resource),
+        matrix(std::move(_matrix)) {
+    if (matrix->Policy() != SimilarityPolicy::ID) {
+      throw std::invalid_argument(
+          "similarity matrix is scored by another policy");
+    }
+  }
 
-  SegmentationContainer(std::vector<SentenceType> &&sentences,
-                        const Embedding<VectorDim, LangType> &em)
-      : GraphOpr(std::make_shared<Graph>(sentences)), EmbeddingOpr(em) {}
+  /// <summary>
+  /// Score all sentence pairs with j - i <= band (0: all pairs) once, to be
+  /// saved and reused by containers that differ only in threshold, edge
+  /// budget or minimum segment size
+  /// </summary>
+  internal::SimilarityMatrix ComputeSimilarityMatrix(size_t band = 0) {
+    if (matrix) {
+      return *matrix;
+    }
+    return internal::SimilarityMatrix::Compute<SimilarityPolicy>(
+        GetScorer(), GraphOpr::graph->GetSentences(), band);
+  }
 
   /// <summary>
   /// Execute segmentation
   /// </summary>
   void Segmentation() {
-    SegmentOpr::segmentable =
-        std::make_unique<internal::Segmentable<Graph, VectorDim, LangType>>(
-            GraphOpr::graph);
+    if (UsesEdges()) {
+      GraphOpr::graph->SetMaximumClique();
+    }
+    ConstructSegment();
+  }
+
+  /// <summary>
+  /// whether edges, cliques or segments were cut short by the deadline
+  /// </summary>
+  bool IsDegraded() const {
+    return GraphOpr::degraded_edges || GraphOpr::graph->IsDegraded() ||
+           (SegmentOpr::segmentable && SegmentOpr::segmentable->degraded);
+  }
+
+  /// <summary>
+  /// Segments for each of thresholds, in the given order, equal to
+  /// SetThreshold, SetGraph and Segmentation per threshold. Pairs are
+  /// scored and sorted once; going from the highest threshold down, edges
+  /// are added to one graph and only cliques of components that gained an
+  /// edge are searched again. Edge budget and minimum segment size apply
+  /// to every threshold. The graph of the lowest threshold is left behind
+  /// </summary>
+  std::vector<std::vector<std::vector<internal::Vertex>>>
+  SweepThresholds(const std::vector<double> &thresholds) {
+    std::vector<std::vector<std::vector<internal::Vertex>>> results(
+        thresholds.size());
+    if (thresholds.empty()) {
+      return results;
+    }
+    GraphOpr::degraded_edges = false;
+    ClearDegraded();
+    std::vector<size_t> order(thresholds.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return thresholds[a] > thresholds[b];
+    });
+    GraphOpr::thereshold = thresholds[order.back()];
+    if (!UsesEdges()) {
+      // boundaries are chosen anew for each threshold, no graph to reuse
+      for (size_t k = 0; k < thresholds.size(); ++k) {
+        ConstructSegment(thresholds[k]);
+        results[k] = SegmentOpr::ExportSegment();
+      }
+      return results;
+    }
+
+    PlanExecution(GraphOpr::thereshold);
+    GRAPHSEG_STATS_ONLY(GraphOpr::stats = SegmentationStats();)
+    auto pairs = [&] {
+      GRAPHSEG_TRACE_SCOPE("SegmentationContainer::SweepThresholds");
+      GRAPHSEG_STATS_PHASE(GraphOpr::stats, SegmentationPhase::EDGE);
+      auto scored = GraphOpr::ScoredPairs(GraphOpr::thereshold);
+      std::sort(scored.begin(), scored.end(), std::greater<>());
+      return scored;
+    }();
+    // the budget keeps the most similar edges, a prefix of sorted pairs
+    const auto limit = std::min(pairs.size(), GraphOpr::MaximumEdges());
+
+    GraphOpr::graph->SetNode();
     GraphOpr::graph->SetMaximumClique();
-    SegmentOpr::segmentable->ConstructSegment(GetEmbedding());
+    size_t added = 0;
+    for (const auto k : order) {
+      for (; added < limit && std::get<0>(pairs[added]) > thresholds[k];
+           ++added) {
+        const auto &[similarity, i, j] = pairs[added];
+        GraphOpr::graph->SetEdge(i, j, similarity);
+      }
+      GraphOpr::graph->UpdateMaximumClique();
+      ConstructSegment();
+      results[k] = SegmentOpr::ExportSegment();
+    }
+    return results;
+  }
+
+  /// <summary>
+  /// Per-phase time and counters of the embedding, graph and last
+  /// Segmentation(). Collected only when GRAPHSEG_STATS is defined, all
+  /// zero otherwise
+  /// </summary>
+  SegmentationStats GetStats() const {
+    auto stats = EmbeddingOpr::embedding->GetStats();
+    stats += GraphOpr::stats;
+    stats += GraphOpr::graph->GetStats();
+    if (SegmentOpr::segmentable) {
+      stats += SegmentOpr::segmentable->GetStats();
+    }
+#ifdef GRAPHSEG_STATS
+    if (plan) {
+      ++stats.plans;
+      stats.banded_plans += plan->edge_band != 0;
+      stats.plan_edge_band = plan->edge_band;
+      stats.greedy_plans += plan->clique_mode == graph::CliqueMode::GREEDY;
+      stats.sampled_pairs += plan->sampled_pairs;
+      stats.estimated_edges += plan->edges;
+      stats.estimated_edge_cost += plan->edge_cost;
+      stats.estimated_clique_cost += plan->clique_cost;
+    }
+    stats.deadline_fallbacks +=
+        static_cast<size_t>(GraphOpr::degraded_edges) +
+        static_cast<size_t>(GraphOpr::graph->IsDegraded()) +
+        static_cast<size_t>(SegmentOpr::segmentable &&
+                            SegmentOpr::segmentable->degraded);
+#endif
+    return stats;
+  }
+
+  /// <summary>
+  /// Let following SetGraph() and SweepThresholds() choose edge band and
+  /// clique mode of the document by cost model (see internal::CostModel),
+  /// in place of SetEdgeBand and SetCliqueMode
+  /// </summary>
+  void SetAutomaticPlan(bool automatic) noexcept {
+    automatic_plan = automatic;
+  }
+
+  /// <summary>
+  /// limits of automatic plans
+  /// </summary>
+  internal::CostModel &GetCostModel() & noexcept { return cost_model; }
+
+  /// <summary>
+  /// plan chosen by last SetGraph() or SweepThresholds(), empty unless
+  /// automatic plans are enabled
+  /// </summary>
+  const std::optional<ExecutionPlan> &GetPlan() const & noexcept {
+    return plan;
   }
 
 private:
-  const Embedding<VectorDim, LangType> &GetEmbedding() {
-    return EmbeddingOpr::embedding;
+  /// <summary>
+  /// segments from maximum cliques already in graph, or by coherence of
+  /// pairs scoring above threshold
+  /// </summary>
+  void ConstructSegment() { ConstructSegment(GraphOpr::thereshold); }
+
+  void ConstructSegment(double threshold) {
+    if (!UsesEdges()) {
+      auto coherence = MakeEngine<internal::CoherenceSegmentable>(
+          GraphOpr::graph->GetGraphSize());
+      coherence->minimum_segment_size = SegmentOpr::minimum_segment_size;
+      coherence->maximum_segment_length = SegmentOpr::maximum_segment_length;
+      coherence->deadline = GraphOpr::deadline;
+      PrepareScores();
+      coherence->Construct(
+          [&](size_t i, size_t j) {
+            return Similarity(static_cast<int>(i), static_cast<int>(j));
+          },
+          threshold);
+      SegmentOpr::segmentable = std::move(coherence);
+      return;
+    }
+
+    auto segmentable =
+        MakeEngine<internal::Segmentable<Graph, VectorDim, LangType>>(
+            GraphOpr::graph);
+    segmentable->minimum_segment_size = SegmentOpr::minimum_segment_size;
+    if (matrix) {
+      segmentable->Construct([&](internal::Vertex a, internal::Vertex b) {
+        return SimilarityPolicy::Relatedness(*matrix, a, b);
+      });
+    } else {
+      const auto &scorer = GetScorer();
+      segmentable->Construct([&](internal::Vertex a, internal::Vertex b) {
+        return scorer.Relatedness(a, b);
+      });
+    }
+    SegmentOpr::segmentable = std::move(segmentable);
+  }
+
+  /// <summary>
+  /// choose and apply a plan from sampled pairs above thd, if automatic
+  /// </summary>
+  void PlanExecution(double thd) {
+    if (!automatic_plan) {
+      return;
+    }
+    GRAPHSEG_TRACE_SCOPE("SegmentationContainer::PlanExecution");
+    PrepareScores();
+    plan = cost_model.Choose(
+        GraphOpr::graph->GetGraphSize(), [&](size_t i, size_t j) {
+          const auto a = static_cast<int>(i), b = static_cast<int>(j);
+          return IsScored(a, b) && MayExceed(a, b, thd) &&
+                 Similarity(a, b) > thd;
+        });
+    GraphOpr::SetEdgeBand(plan->edge_band);
+    GraphOpr::SetCliqueMode(plan->clique_mode);
+  }
+
+  template <class Sentences>
+  static std::shared_ptr<Graph> MakeGraph(Sentences &&sentences,
+                                          std::pmr::memory_resource *resource) {
+    return std::allocate_shared<Graph>(
+        std::pmr::polymorphic_allocator<Graph>(resource),
+        std::forward<Sentences>(sentences), resource);
+  }
+
+  template <class Engine, class... Args>
+  std::shared_ptr<Engine> MakeEngine(Args &&...args) const {
+    return std::allocate_shared<Engine>(
+        std::pmr::polymorphic_allocator<Engine>(GraphOpr::resource),
+        std::forward<Args>(args)..., GraphOpr::resource);
   }
 
+  /// <summary>
+  /// scorer of policy, built on first use (centroid scores are computed
+  /// once for all pairs then)
+  /// </summary>
+  const Scorer &GetScorer() {
+    if (!scorer) {
+      scorer.emplace(*EmbeddingOpr::embedding,
+                     GraphOpr::graph->GetSentences());
+    }
+    return *scorer;
+  }
+
+  /// <summary>
+  /// forget the fallback of the last segmentation, its segments are built
+  /// anew
+  /// </summary>
+  void ClearDegraded() {
+    if (SegmentOpr::segmentable) {
+      SegmentOpr::segmentable->degraded = false;
+    }
+  }
+
+  void PrepareScores() {
+    if (!matrix) {
+      GetScorer();
+    }
+  }
+
+  /// <summary>
+  /// only the clique engine needs graph edges
+  /// </summary>
+  bool UsesEdges() const noexcept {
+    return SegmentOpr::engine == SegmentationEngine::CLIQUE;
+  }
+
+  bool IsScored(int i, int j) const {
+    return !matrix || matrix->Contains(static_cast<size_t>(i),
+                                       static_cast<size_t>(j));
+  }
+
+  bool MayExceed(int i, int j, double thd) const {
+    return matrix || scorer->MayExceed(static_cast<size_t>(i),
+                                       static_cast<size_t>(j), thd);
+  }
+
+  double Similarity(int i, int j) const {
+    if (matrix) {
+      return matrix->Get(static_cast<size_t>(i), static_cast<size_t>(j));
+    }
+    return scorer->Similarity(static_cast<size_t>(i), static_cast<size_t>(j));
+  }
+
+  /// <summary>
+  /// precomputed scores replacing embedding, null if not given
+  /// </summary>
+  std::shared_ptr<const internal::SimilarityMatrix> matrix;
+
+  std::optional<Scorer> scorer;
+
+  bool automatic_plan = false;
+  internal::CostModel cost_model;
+  std::optional<ExecutionPlan> plan;
+
   friend GraphOpr;
 };
 } // namespace GraphSeg
@@ -7,6 +7,9 @@
 #include <codecvt>
 #include <type_traits>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <iostream>
 #include <algorithm>
@@ -68,6 +71,16 @@ public:
     return std::move(terms);
   }
 
+  /// <summary>
+  /// Get distinct terms with their occurrence count, in order of first
+  /// occurrence
+  /// </summary>
+  GRAPHSEG_INLINE_CONST std::vector<std::pair<std::string, unsigned int>> &
+  GetTermCounts() const &
+  {
+    return term_counts;
+  }
+
   /// <summary>
   /// Get term size
   /// </summary>
@@ -131,10 +144,26 @@ private:
       item += *itr;
     }
     terms.emplace_back(item);
+    CountTerm();
+  }
+
+  void CountTerm()
+  {
+    std::unordered_map<std::string_view, size_t> index;
+    for (const auto &term : terms)
+    {
+      const auto [itr, inserted] = index.emplace(term, term_counts.size());
+      if (inserted)
+      {
+        term_counts.emplace_back(term, 0);
+      }
+      ++term_counts[itr->second].second;
+    }
   }
 
   std::string sentence;
   std::vector<std::string> terms;
+  std::vector<std::pair<std::string, unsigned int>> term_counts;
 };
 } // namespace GraphSeg
 
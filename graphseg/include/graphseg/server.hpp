@@ -0,0 +1,425 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_SERVER_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_SERVER_HPP
+
+#include "graphseg/document_segmenter.hpp"
+#include "graphseg/internal/segment_cache.hpp"
+#include "graphseg/internal/utils/bounded_queue.hpp"
+#include "graphseg/internal/utils/frame.hpp"
+#include "graphseg/internal/utils/trace.hpp"
+#include "graphseg/language.hpp"
+#include "graphseg/segmentation_container.hpp"
+#include "graphseg/sentence.hpp"
+#include "graphseg/text.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <codecvt>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <locale>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace GraphSeg {
+/// <summary>
+/// request type of graphseg_server
+/// </summary>
+enum class ServerOpcode : uint32_t {
+  /// <summary>
+  /// UTF-8 article, split into sentences and tagged by the server
+  /// </summary>
+  SEGMENT_TEXT = 1,
+
+  /// <summary>
+  /// UTF-8 sentences separated by '\n', tagged by the server. blank lines
+  /// are skipped
+  /// </summary>
+  SEGMENT_SENTENCES = 2
+};
+
+/// <summary>
+/// settings of requests are those of SegmenterConfig, deadline counted
+/// from receiving a request and arena_size per thread
+/// </summary>
+struct ServerConfig : SegmenterConfig {
+  std::string socket_path;
+
+  /// <summary>
+  /// requests served concurrently
+  /// </summary>
+  size_t threads = 4;
+
+  /// <summary>
+  /// connections with a request waiting for a free thread
+  /// </summary>
+  size_t backlog = 64;
+
+  /// <summary>
+  /// requests larger than this are rejected and the connection is closed
+  /// </summary>
+  size_t max_request_size = 64 * 1024 * 1024;
+};
+
+/// <summary>
+/// Segmentation daemon on a Unix domain socket. Models and taggers are
+/// loaded once, so a request costs tagging plus graph work only.
+/// Frames are the ones of script/worker.py:
+///   request  : uint32 opcode (ServerOpcode) | uint32 length | payload
+///   response : uint32 status (0: ok)        | uint32 length | payload
+/// An ok payload is {"sentences":N,"segments":[[begin,end],...]} with
+/// [begin, end) sentence offsets, otherwise an error message. A connection
+/// may carry any number of requests and holds a thread only while one of
+/// them is served; between requests it is watched by Run()
+/// </summary>
+template <class Graph, int VectorDim, Lang LangType = Lang::EN,
+          class SimilarityPolicy = TermPairSimilarity>
+class Server : public Language<LangType> {
+  using Base = Language<LangType>;
+  using SentenceType = Sentence<LangType>;
+  using Segmenter =
+      DocumentSegmenter<Graph, VectorDim, LangType, SimilarityPolicy>;
+
+public:
+  explicit Server(ServerConfig _config)
+      : config(std::move(_config)), segmenter(config),
+        connections(config.backlog) {}
+
+  Server(const Server &) = delete;
+  Server &operator=(const Server &) = delete;
+
+  /// <summary>
+  /// bind socket and serve until Stop()
+  /// </summary>
+  void Run() {
+    const int listen_fd = Listen();
+    OpenWakePipe(listen_fd);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < std::max<size_t>(config.threads, 1); ++i) {
+      workers.emplace_back([this]() { Work(); });
+    }
+
+    // connections between requests
+    std::vector<int> idle;
+    std::vector<pollfd> pfds;
+    while (!stopping.load()) {
+      pfds.assign({{listen_fd, POLLIN, 0}, {wake[0], POLLIN, 0}});
+      for (const auto fd : idle) {
+        pfds.push_back({fd, POLLIN, 0});
+      }
+      // wake up regularly to notice Stop()
+      const auto ready = poll(pfds.data(), pfds.size(), 200);
+      if (ready <= 0) {
+        continue;
+      }
+      // a request (or hangup) hands its connection to a worker, the rest
+      // keep waiting here
+      size_t kept = 0;
+      for (size_t i = 0; i < idle.size(); ++i) {
+        int fd = idle[i];
+        if (pfds[i + 2].revents != 0) {
+          connections.Push(std::move(fd));
+        } else {
+          idle[kept++] = fd;
+        }
+      }
+      idle.resize(kept);
+      if (pfds[1].revents != 0) {
+        DrainWakePipe();
+        std::lock_guard<std::mutex> lock(released_mtx);
+        idle.insert(idle.end(), released.begin(), released.end());
+        released.clear();
+      }
+      if (pfds[0].revents != 0) {
+        const int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd >= 0) {
+          idle.push_back(fd);
+        }
+      }
+    }
+
+    connections.Close();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+    for (const auto fd : idle) {
+      close(fd);
+    }
+    for (const auto fd : released) {
+      close(fd);
+    }
+    released.clear();
+    close(wake[0]);
+    close(wake[1]);
+    close(listen_fd);
+    unlink(config.socket_path.c_str());
+  }
+
+  /// <summary>
+  /// ask Run() to return. only sets a flag, so it is safe in signal handler.
+  /// requests being served are answered, then every connection is closed
+  /// </summary>
+  void Stop() noexcept { stopping.store(true); }
+
+  /// <summary>
+  /// segment one request payload and return response payload. graph work
+  /// allocates from resource
+  /// </summary>
+  std::string
+  Handle(ServerOpcode opcode, const std::string &payload,
+         std::pmr::memory_resource *resource = std::pmr::get_default_resource()) {
+    GRAPHSEG_TRACE_SCOPE("Server::Handle");
+    const auto deadline = segmenter.Deadline();
+    std::optional<internal::SegmentCacheKey> key;
+    if (config.cache) {
+      key = segmenter.MakeKey(payload, static_cast<uint32_t>(opcode));
+      if (const auto hit = config.cache->Find(*key)) {
+        return "{" + SegmentationJson(hit->sentences, hit->segments) + "}";
+      }
+    }
+
+    const auto sentences = Split(opcode, payload);
+    // a single sentence is its own segment, no embedding needed
+    const auto result = segmenter.Segment(
+        sentences, sentences.size() > 1 ? segmenter.Embed(sentences) : nullptr,
+        deadline, resource);
+    if (key) {
+      segmenter.Remember(*key, sentences.size(), result);
+    }
+    return "{" +
+           SegmentationJson(sentences.size(), result.segments,
+                            result.degraded) +
+           "}";
+  }
+
+  uint64_t GetRequestCount() const noexcept { return requests.load(); }
+
+  uint64_t GetErrorCount() const noexcept { return errors.load(); }
+
+private:
+  int Listen() {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (config.socket_path.size() >= sizeof(addr.sun_path)) {
+      throw std::invalid_argument(config.socket_path + ": path too long");
+    }
+    std::strcpy(addr.sun_path, config.socket_path.c_str());
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+      throw std::runtime_error(std::string("socket: ") +
+                               std::strerror(errno));
+    }
+    unlink(config.socket_path.c_str());
+    if (bind(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) !=
+            0 ||
+        listen(fd, static_cast<int>(config.backlog)) != 0) {
+      const auto message = config.socket_path + ": " + std::strerror(errno);
+      close(fd);
+      throw std::runtime_error(message);
+    }
+    return fd;
+  }
+
+  void Work() {
+    // load tagger dictionary of this thread before the first request
+    if constexpr (LangType == Lang::JP) {
+      Base::SentenceTagger("");
+    }
+    std::vector<std::byte> scratch(config.arena_size);
+    while (auto fd = connections.Pop()) {
+      if (Serve(*fd, scratch) && !stopping.load()) {
+        Release(*fd);
+      } else {
+        close(*fd);
+      }
+    }
+  }
+
+  /// <summary>
+  /// answer the request waiting on fd, false once the connection is done
+  /// </summary>
+  bool Serve(int fd, std::vector<std::byte> &scratch) {
+    internal::utils::FrameHeader header;
+    if (!ReadFull(fd, header.data(), header.size())) {
+      return false;
+    }
+    const auto opcode = internal::utils::DecodeUint32(header.data());
+    const auto length = internal::utils::DecodeUint32(header.data() + 4);
+    if (length > config.max_request_size) {
+      ++errors;
+      Reply(fd, 1, "request too large");
+      return false;
+    }
+    std::string payload(length, '\0');
+    if (!ReadFull(fd, payload.data(), payload.size())) {
+      return false;
+    }
+    ++requests;
+    try {
+      if (opcode != static_cast<uint32_t>(ServerOpcode::SEGMENT_TEXT) &&
+          opcode != static_cast<uint32_t>(ServerOpcode::SEGMENT_SENTENCES)) {
+        throw std::invalid_argument("unknown opcode " +
+                                    std::to_string(opcode));
+      }
+      std::pmr::monotonic_buffer_resource arena(scratch.data(),
+                                                scratch.size());
+      const auto response =
+          Handle(static_cast<ServerOpcode>(opcode), payload, &arena);
+      return Reply(fd, 0, response);
+    } catch (const std::exception &e) {
+      ++errors;
+      return Reply(fd, 1, e.what());
+    }
+  }
+
+  /// <summary>
+  /// hand connection back to Run() to wait for its next request
+  /// </summary>
+  void Release(int fd) {
+    {
+      std::lock_guard<std::mutex> lock(released_mtx);
+      released.push_back(fd);
+    }
+    // pipe is non-blocking: if it is full, Run() is woken up already
+    const char c = 0;
+    while (write(wake[1], &c, 1) < 0 && errno == EINTR) {
+    }
+  }
+
+  void OpenWakePipe(int listen_fd) {
+    if (pipe(wake.data()) != 0) {
+      const auto message = std::string("pipe: ") + std::strerror(errno);
+      close(listen_fd);
+      throw std::runtime_error(message);
+    }
+    for (const auto fd : wake) {
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+  }
+
+  void DrainWakePipe() {
+    char buffer[64];
+    while (read(wake[0], buffer, sizeof(buffer)) > 0) {
+    }
+  }
+
+  std::vector<SentenceType> Split(ServerOpcode opcode,
+                                  const std::string &payload) {
+    if (opcode == ServerOpcode::SEGMENT_TEXT) {
+      std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> cv;
+      Text<LangType> text(cv.from_bytes(payload), "");
+      return text.GetSentences();
+    }
+    std::vector<SentenceType> sentences;
+    size_t begin = 0;
+    while (begin < payload.size()) {
+      auto end = payload.find('\n', begin);
+      if (end == std::string::npos) {
+        end = payload.size();
+      }
+      // the cache key drops blank lines, so they must not be sentences
+      const auto line = payload.substr(begin, end - begin);
+      if (!internal::SegmentCache::IsBlank(line)) {
+        sentences.emplace_back(Base::SentenceTagger(line));
+      }
+      begin = end + 1;
+    }
+    return sentences;
+  }
+
+  /// <summary>
+  /// gives up after Stop(), so a client stalling within a frame cannot
+  /// keep Run() from returning
+  /// </summary>
+  bool ReadFull(int fd, void *data, size_t size) {
+    auto ptr = static_cast<char *>(data);
+    while (size > 0) {
+      pollfd pfd{fd, POLLIN, 0};
+      const auto ready = poll(&pfd, 1, 200);
+      if (ready < 0 && errno != EINTR) {
+        return false;
+      }
+      if (ready <= 0) {
+        if (stopping.load()) {
+          return false;
+        }
+        continue;
+      }
+      const auto n = read(fd, ptr, size);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        return false;
+      }
+      ptr += n;
+      size -= static_cast<size_t>(n);
+    }
+    return true;
+  }
+
+  static bool WriteFull(int fd, const void *data, size_t size) {
+    auto ptr = static_cast<const char *>(data);
+    while (size > 0) {
+      const auto n = write(fd, ptr, size);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        return false;
+      }
+      ptr += n;
+      size -= static_cast<size_t>(n);
+    }
+    return true;
+  }
+
+  static bool Reply(int fd, uint32_t status, const std::string &payload) {
+    const auto header = internal::utils::EncodeFrameHeader(
+        status, static_cast<uint32_t>(payload.size()));
+    return WriteFull(fd, header.data(), header.size()) &&
+           WriteFull(fd, payload.data(), payload.size());
+  }
+
+  ServerConfig config;
+  Segmenter segmenter;
+
+  /// <summary>
+  /// connections with a request, waiting for a worker
+  /// </summary>
+  internal::utils::BoundedQueue<int> connections;
+
+  /// <summary>
+  /// connections answered by workers, not yet watched by Run()
+  /// </summary>
+  std::vector<int> released;
+  std::mutex released_mtx;
+
+  /// <summary>
+  /// written by Release() to wake Run() from poll
+  /// </summary>
+  std::array<int, 2> wake{-1, -1};
+
+  std::atomic<bool> stopping{false};
+  std::atomic<uint64_t> requests{0};
+  std::atomic<uint64_t> errors{0};
+};
+} // namespace GraphSeg
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef GRAPHSEG_CPP_GRAPHSEG_SIMILARITY_POLICY_HPP
+#define GRAPHSEG_CPP_GRAPHSEG_SIMILARITY_POLICY_HPP
+
+#include "graphseg/embedding.hpp"
+#include "graphseg/internal/similarity_matrix.hpp"
+#include "graphseg/internal/utils/vector_kernel.hpp"
+#include "graphseg/language.hpp"
+#include "graphseg/sentence.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace GraphSeg {
+/// <summary>
+/// Sentence similarity of the original algorithm: cosine of every term
+/// pair weighted by the smaller information content, summed
+/// (Embedding::GetSimilarity). O(|s1| |s2| D) per pair over distinct terms
+/// </summary>
+struct TermPairSimilarity {
+  /// <summary>
+  /// identifies the scores in saved matrices and cache keys
+  /// </summary>
+  static constexpr uint32_t ID = 0;
+
+  /// <summary>
+  /// threshold for tools that do not set one, scores grow with sentence
+  /// length
+  /// </summary>
+  static constexpr double DEFAULT_THRESHOLD = 300.0;
+
+  /// <summary>
+  /// Scorer::Relatedness of sentences i and j from saved scores
+  /// </summary>
+  static double Relatedness(const internal::SimilarityMatrix &matrix,
+                            size_t i, size_t j) {
+    return matrix.NormalizedSimilarity(i, j);
+  }
+
+  template <int VectorDim, Lang LangType> class Scorer {
+  public:
+    Scorer(const Embedding<VectorDim, LangType> &_embedding,
+           const std::vector<Sentence<LangType>> &_sentences)
+        : embedding(_embedding), sentences(_sentences) {
+      bags.reserve(sentences.size());
+      profiles.reserve(sentences.size());
+      for (const auto &sentence : sentences) {
+        bags.emplace_back(embedding.GetTermBag(sentence));
+        profiles.emplace_back(embedding.GetBoundProfile(sentence));
+      }
+    }
+
+    /// <summary>
+    /// edge weight of sentences i and j, from term bags resolved once
+    /// </summary>
+    double Similarity(size_t i, size_t j) const {
+      return embedding.GetSimilarity(bags[i], bags[j]);
+    }
+
+    /// <summary>
+    /// false if Similarity(i, j) cannot exceed thd, decided from
+    /// Embedding::SimilarityUpperBound without the term pair loop. the
+    /// bound gets a relative margin far above rounding error, so no pair
+    /// that Similarity() would keep is dropped
+    /// </summary>
+    bool MayExceed(size_t i, size_t j, double thd) const {
+      const auto bound =
+          Embedding<VectorDim, LangType>::SimilarityUpperBound(profiles[i],
+                                                               profiles[j]);
+      return !(bound * (1.0 + 1e-9) <= thd);
+    }
+
+    /// <summary>
+    /// relatedness used when merging small segments
+    /// </summary>
+    double Relatedness(size_t i, size_t j) const {
+      // same as Embedding::NormalizedSimilarity
+      const auto sim = Similarity(i, j);
+      const auto size1 = static_cast<double>(sentences[i].GetSize());
+      const auto size2 = static_cast<double>(sentences[j].GetSize());
+      return (sim / size1 + sim / size2) / 2;
+    }
+
+  private:
+    const Embedding<VectorDim, LangType> &embedding;
+    const std::vector<Sentence<LangType>> &sentences;
+
+    std::vector<typename Embedding<VectorDim, LangType>::TermBag> bags;
+    std::vector<typename Embedding<VectorDim, LangType>::BoundProfile>
+        profiles;
+  };
+};
+
+/// <summary>
+/// Cosine of sentence centroids (Embedding::Centroid). Centroids are built
+/// once and all pairs are scored by one blocked A * A^T, so a pair costs
+/// a single dot product. Faster by the average term count squared, but
+/// term-level matches are blurred, and scores lie in [-1, 1]: thresholds
+/// are on that scale, not the one of TermPairSimilarity
+/// </summary>
+struct CentroidSimilarity {
+  static constexpr uint32_t ID = 1;
+
+  static constexpr double DEFAULT_THRESHOLD = 0.5;
+
+  static double Relatedness(const internal::SimilarityMatrix &matrix,
+                            size_t i, size_t j) {
+    return matrix.Get(i, j);
+  }
+
+  template <int VectorDim, Lang LangType> class Scorer {
+  public:
+    Scorer(const Embedding<VectorDim, LangType> &embedding,
+           const std::vector<Sentence<LangType>> &sentences)
+        : size(sentences.size()), scores(size * size, 0.0) {
+      const auto dim = embedding.Dimension();
+      std::vector<double> centroids(size * dim);
+      for (size_t i = 0; i < size; ++i) {
+        embedding.Centroid(sentences[i], centroids.data() + i * dim);
+      }
+      internal::utils::GramUpper(centroids.data(), size, dim, scores.data(),
+                                 internal::utils::SelectDotKernel(dim));
+    }
+
+    double Similarity(size_t i, size_t j) const {
+      return scores[std::min(i, j) * size + std::max(i, j)];
+    }
+
+    /// <summary>
+    /// scores are already computed, nothing to skip
+    /// </summary>
+    bool MayExceed(size_t, size_t, double) const { return true; }
+
+    /// <summary>
+    /// cosine is already independent of sentence length
+    /// </summary>
+    double Relatedness(size_t i, size_t j) const { return Similarity(i, j); }
+
+  private:
+    size_t size;
+
+    /// <summary>
+    /// size x size, upper triangle filled
+    /// </summary>
+    std::vector<double> scores;
+  };
+};
+} // namespace GraphSeg
+
+#endif
@@ -2,6 +2,7 @@
 #define GRAPHSEG_CPP_GRAPHSEG_TEXT_FACTORY_HPP
 
 #include "graphseg/internal/utils/string.hpp"
+#include "graphseg/internal/utils/trace.hpp"
 #include "graphseg/language.hpp"
 #include "graphseg/sentence.hpp"
 #include "graphseg/text.hpp"
@@ -10,6 +11,7 @@
 #include <fstream>
 #include <locale>
 #include <sstream>
+#include <stdexcept>
 #include <vector>
 
 #include <mecab.h>
@@ -17,8 +19,10 @@
 namespace GraphSeg {
 std::wstring ReadTextFile(const std::string &path, std::string current_locale) {
   std::wifstream wif(path);
+  if (!wif) {
+    throw std::runtime_error(path + ": cannot open");
+  }
   wif.imbue(std::locale(current_locale));
-  std::wcout.imbue(std::locale(current_locale));
   std::wstringstream wss;
   wss << wif.rdbuf();
   return wss.str();
@@ -31,6 +35,7 @@ class TextFactory : public Language<LangType> {
 public:
   static std::vector<Text<LangType>>
   Execute(const std::vector<std::string> &paths) {
+    GRAPHSEG_TRACE_SCOPE("TextFactory::Execute");
     std::vector<Text<LangType>> articles;
     for (auto &&path : paths) {
       auto text = ReadTextFile(path, Base::Locale());
@@ -40,6 +45,7 @@ public:
   }
 
   static Text<LangType> Execute(const std::string &path) {
+    GRAPHSEG_TRACE_SCOPE("TextFactory::Execute");
     auto text = ReadTextFile(path, Base::Locale());
     return Text<LangType>(text, path);
   }
@@ -9,9 +9,14 @@ total_count = 0
 for term, count in dist.items():
     total_count += count
 
-if __name__ == "__main__":
-    line = input()
+
+def count_terms(words):
     out = {"corpus_size": len(dist), "total_count": total_count} # |C|
-    for word in line.split(" "):
+    for word in words:
         out[word] = dist[word]
-    print(json.dumps(out))
\ No newline at end of file
+    return out
+
+
+if __name__ == "__main__":
+    line = input()
+    print(json.dumps(count_terms(line.split(" "))))
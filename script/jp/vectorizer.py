@@ -4,6 +4,9 @@ import json
 import numpy
 from gensim.models.word2vec import Word2Vec
 
+sys.path.append(os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+import vector_format
+
 
 class MyEncoder(json.JSONEncoder):
     def default(self, obj):
@@ -23,19 +26,30 @@ model_path = os.path.join(
 
 model = Word2Vec.load(model_path)
 
-line = input()
-
-out = {}
-for word in line.split(" "):
-    vector = None
-    try:
-        if word[-1] == ".":
-            vector = model.wv[word[:-1]]
-        else:
-            vector = model.wv[word]
-    except:
-        continue
-    if len(vector) != 0:      
-        out[word] = vector
 
-print(json.dumps(out, cls=MyEncoder))
+def vectorize(words):
+    out = {}
+    for word in words:
+        vector = None
+        try:
+            if word[-1] == ".":
+                vector = model.wv[word[:-1]]
+            else:
+                vector = model.wv[word]
+        except:
+            continue
+        if len(vector) != 0:
+            out[word] = vector
+    return out
+
+
+def vectorize_binary(words):
+    return vector_format.encode(vectorize(words), model.wv.vector_size)
+
+
+if __name__ == "__main__":
+    line = input()
+    if "--binary" in sys.argv:
+        sys.stdout.buffer.write(vectorize_binary(line.split()))
+    else:
+        print(json.dumps(vectorize(line.split(" ")), cls=MyEncoder))
@@ -0,0 +1,45 @@
+import struct
+
+import numpy
+
+# Binary word vector transport format read by GraphSeg::internal::VectorFormatView
+#
+# header (32 bytes, little-endian)
+#   char[4] magic "GSVF" | uint32 version | uint32 dimension
+#   uint32 dtype (0: float32, 1: float16) | uint32 count | uint32 reserved
+#   uint64 byte size of term table
+# term table: count x (uint32 byte length | UTF-8 bytes)
+# zero padding up to 8 byte boundary
+# rows: count x dimension x dtype, in term table order
+
+MAGIC = b"GSVF"
+VERSION = 1
+FLOAT32 = 0
+FLOAT16 = 1
+
+HEADER = struct.Struct("<4sIIIIIQ")
+
+
+def encode(vectors, dimension, half=False):
+    """vectors: dict of term -> 1-d array of length dimension"""
+    table = bytearray()
+    rows = []
+    for term, vector in vectors.items():
+        data = term.encode("utf-8")
+        table += struct.pack("<I", len(data))
+        table += data
+        rows.append(vector)
+
+    dtype = "<f2" if half else "<f4"
+    body = numpy.asarray(rows, dtype=dtype).reshape(len(rows), dimension)
+    header = HEADER.pack(
+        MAGIC,
+        VERSION,
+        dimension,
+        FLOAT16 if half else FLOAT32,
+        len(rows),
+        0,
+        len(table),
+    )
+    padding = b"\0" * (-(len(header) + len(table)) % 8)
+    return header + bytes(table) + padding + body.tobytes()
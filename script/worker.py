@@ -0,0 +1,77 @@
+import json
+import os
+import struct
+import sys
+
+# Long-lived worker serving vectorizer.py / frequency.py over stdin/stdout
+# so that models and corpora are loaded once per process.
+#
+# request:  uint32 opcode | uint32 length | payload (terms separated by " ")
+# response: uint32 status | uint32 length | payload
+# all integers are little-endian. status 0 means success, otherwise payload
+# is an error message.
+
+VECTORIZE = 1
+FREQUENCY = 2
+VECTORIZE_BINARY = 3
+
+HEADER = struct.Struct("<II")
+
+
+def read_exact(stream, size):
+    buf = b""
+    while len(buf) < size:
+        chunk = stream.read(size - len(buf))
+        if not chunk:
+            return None
+        buf += chunk
+    return buf
+
+
+def main():
+    lang_dir = os.path.join(os.path.dirname(os.path.abspath(__file__)), sys.argv[1])
+    sys.path.insert(0, lang_dir)
+
+    # keep a private handle on the protocol channel and send everything
+    # printed by libraries to stderr
+    out = os.fdopen(os.dup(1), "wb")
+    os.dup2(2, 1)
+
+    import frequency
+    import vectorizer
+
+    stdin = sys.stdin.buffer
+    while True:
+        header = read_exact(stdin, HEADER.size)
+        if header is None:
+            break
+        opcode, length = HEADER.unpack(header)
+        payload = read_exact(stdin, length)
+        if payload is None:
+            break
+        words = payload.decode("utf-8").split()
+
+        status = 0
+        try:
+            if opcode == VECTORIZE:
+                body = json.dumps(
+                    vectorizer.vectorize(words), cls=vectorizer.MyEncoder
+                ).encode("utf-8")
+            elif opcode == VECTORIZE_BINARY:
+                body = vectorizer.vectorize_binary(words)
+            elif opcode == FREQUENCY:
+                body = json.dumps(frequency.count_terms(words)).encode("utf-8")
+            else:
+                status = 1
+                body = ("unknown opcode %d" % opcode).encode("utf-8")
+        except Exception as e:
+            status = 1
+            body = str(e).encode("utf-8")
+
+        out.write(HEADER.pack(status, len(body)))
+        out.write(body)
+        out.flush()
+
+
+if __name__ == "__main__":
+    main()
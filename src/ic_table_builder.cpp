@@ -0,0 +1,47 @@
+#include "graphseg/internal/ic_table.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+using namespace GraphSeg::internal;
+
+// Build information content table from a local corpus.
+// Corpus must be tokenized (terms separated by white spaces),
+// e.g. `mecab -Owakati` output for japanese text.
+int main(int argc, char **argv)
+{
+  if (argc != 3)
+  {
+    std::cerr << "usage: " << argv[0] << " <corpus.txt> <output.ic>"
+              << std::endl;
+    return 1;
+  }
+
+  std::ifstream corpus(argv[1]);
+  if (!corpus)
+  {
+    std::cerr << "cannot open " << argv[1] << std::endl;
+    return 1;
+  }
+
+  std::unordered_map<std::string, uint32_t> counts;
+  std::string term;
+  while (corpus >> term)
+  {
+    ++counts[term];
+  }
+
+  std::ofstream output(argv[2], std::ios::binary);
+  ICTable::Write(output, counts);
+  if (!output)
+  {
+    std::cerr << "failed to write " << argv[2] << std::endl;
+    return 1;
+  }
+
+  std::cout << counts.size() << " terms written to " << argv[2] << std::endl;
+  return 0;
+}
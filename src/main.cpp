@@ -1,53 +1,514 @@
-#define DEBUG
-
 #include "graphseg/graphseg.hpp"
+#include "options.hpp"
 
-#include <vector>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <getopt.h>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <vector>
 
-using namespace std;
 using namespace GraphSeg;
 using namespace GraphSeg::graph;
+using namespace GraphSeg::cli;
 
-int main()
+namespace
 {
-  constexpr Lang LangType = Lang::JP;
-  constexpr int VectorDim = 50;
+constexpr Lang LangType = Lang::JP;
+// dimension is taken from the loaded model
+constexpr int VectorDim = DynamicDim;
+#ifdef GRAPHSEG_CENTROID_SIMILARITY
+using SimilarityType = CentroidSimilarity;
+#else
+using SimilarityType = TermPairSimilarity;
+#endif
 
-  std::string dataPath = "/Users/shimizurei/graphseg-cpp/data/article01.txt";
+using PipelineType =
+    Pipeline<UndirectedGraph<LangType>, VectorDim, LangType, SimilarityType>;
 
-  auto text = TextFactory<LangType>::Execute(dataPath);
+struct Options
+{
+  std::vector<std::string> inputs;
+  std::vector<std::string> lists;
+  std::string output;
+  std::string ic_table;
+  std::string vectors;
+  std::string trace;
+  std::string cache_dir;
+  size_t cache_size = 0;
+  bool persistent_worker = false;
+  bool shared_vocabulary = true;
+  PipelineConfig config;
+};
 
-  Embedding<VectorDim, LangType> em;
+void Usage(const char *program, std::ostream &os)
+{
+  os << "usage: " << program << " [options] [file|directory|-]...\n"
+     << "\n"
+     << "Segment documents and write one JSON line per document.\n"
+     << "Without inputs, paths are read from stdin (one per line).\n"
+     << "'-' reads a single document from stdin.\n"
+     << "\n"
+     << "  -l, --list FILE          read paths from FILE ('-' for stdin)\n"
+     << "  -o, --output FILE        write JSONL to FILE instead of stdout\n"
+     << "  -j, --threads N          workers of tag, embed and segment stages\n"
+     << "      --workers R,T,E,S    workers of each stage\n"
+     << "      --queue-capacity N   capacity of queues between stages\n"
+     << "  -t, --threshold X        edge similarity threshold (default "
+     << SimilarityType::DEFAULT_THRESHOLD << ")\n"
+     << "  -b, --edge-budget X      keep at most X edges per sentence\n"
+     << "  -m, --min-segment-size N minimum sentences per segment\n"
+     << "      --clique-mode MODE   exact (default) or greedy, which bounds\n"
+     << "                           clique search time of dense documents\n"
+     << "      --engine NAME        clique (default) or coherence, which sets\n"
+     << "                           boundaries in O(N W) for long documents\n"
+     << "      --max-segment-length W\n"
+     << "                           longest segment of coherence engine\n"
+     << "      --auto-plan          choose edge band and clique mode of each\n"
+     << "                           document from sampled edge density\n"
+     << "      --deadline MS        segment each document within MS ms of\n"
+     << "                           reading it, cheaper work past that is\n"
+     << "                           flagged \"degraded\":true\n"
+     << "      --no-small-documents segment documents of at most 128\n"
+     << "                           sentences on the general graph too\n"
+     << "      --vectors FILE       embedding model in vector format\n"
+     << "      --ic-table FILE      precomputed information content table\n"
+     << "      --persistent-worker  keep one python worker alive\n"
+     << "      --no-shared-vocabulary\n"
+     << "                           resolve terms of every document alone\n"
+     << "      --cache-size N       cache N results in memory\n"
+     << "      --cache-dir DIR      cache results on disk in DIR\n"
+     << "      --similarity-dir DIR save sentence scores to DIR/<id>.gssm\n"
+     << "      --similarity-band N  save only pairs at most N apart\n"
+#ifdef GRAPHSEG_TRACE
+     << "      --trace FILE         write Chrome trace JSON to FILE\n"
+#endif
+     << "  -h, --help               show this help\n";
+}
 
-  for (auto &sentence : text.GetSentences())
+bool ParseWorkers(const std::string &s,
+                  std::array<size_t, PipelineStageSize> &workers)
+{
+  std::stringstream ss(s);
+  std::string item;
+  size_t i = 0;
+  while (std::getline(ss, item, ','))
   {
-    em.AddSentenceWords(sentence);
+    if (i == PipelineStageSize || !ParseSize(item.c_str(), workers[i]))
+    {
+      return false;
+    }
+    ++i;
   }
-  em.GetWordEmbeddings();
+  return i == PipelineStageSize;
+}
 
-  for (const auto &sentnece : text.GetSentences())
+void ReadPathList(std::istream &is, std::vector<std::string> &paths)
+{
+  std::string line;
+  while (std::getline(is, line))
+  {
+    if (!line.empty())
+    {
+      paths.emplace_back(line);
+    }
+  }
+}
+
+/// <summary>
+/// expand directory into regular files below it, in a stable order
+/// </summary>
+void CollectPaths(const std::string &input, std::vector<std::string> &paths)
+{
+  if (input == "-")
+  {
+    paths.emplace_back("/dev/stdin");
+    return;
+  }
+  if (!std::filesystem::is_directory(input))
+  {
+    paths.emplace_back(input);
+    return;
+  }
+  std::vector<std::string> files;
+  for (const auto &entry :
+       std::filesystem::recursive_directory_iterator(input))
+  {
+    if (entry.is_regular_file())
+    {
+      files.emplace_back(entry.path().string());
+    }
+  }
+  std::sort(files.begin(), files.end());
+  paths.insert(paths.end(), files.begin(), files.end());
+}
+
+void WriteJsonString(std::ostream &os, const std::string &s)
+{
+  static constexpr char hex[] = "0123456789abcdef";
+  os << '"';
+  for (const auto c : s)
+  {
+    switch (c)
+    {
+    case '"':
+      os << "\\\"";
+      break;
+    case '\\':
+      os << "\\\\";
+      break;
+    case '\n':
+      os << "\\n";
+      break;
+    case '\t':
+      os << "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20)
+      {
+        const auto u = static_cast<unsigned char>(c);
+        os << "\\u00" << hex[u >> 4] << hex[u & 0xf];
+      }
+      else
+      {
+        os << c;
+      }
+    }
+  }
+  os << '"';
+}
+
+/// <summary>
+/// {"id":0,"path":"a.txt","sentences":9,"segments":[[0,4],[4,9]]}
+/// segments are [begin, end) sentence offsets, "degraded":true follows
+/// them if the deadline cut segmentation short
+/// </summary>
+void WriteDocument(std::ostream &os, const PipelineType::Document &document)
+{
+  os << "{\"id\":" << document.id << ",\"path\":";
+  WriteJsonString(os, document.path);
+  if (!document.error.empty())
+  {
+    os << ",\"error\":";
+    WriteJsonString(os, document.error);
+    os << "}\n";
+    return;
+  }
+  os << ',' << SegmentationJson(document.sentences, document.segments,
+                                document.degraded)
+     << "}\n";
+}
+
+void WriteSummary(std::ostream &os, const PipelineType &pipeline,
+                  size_t documents, size_t failed, size_t sentences)
+{
+  const auto seconds =
+      std::chrono::duration<double>(pipeline.GetElapsedTime()).count();
+  const auto rate = [&](size_t n) {
+    return seconds > 0.0 ? static_cast<double>(n) / seconds : 0.0;
+  };
+  os << "documents: " << documents << " (" << failed << " failed)\n"
+     << "sentences: " << sentences << "\n"
+     << "elapsed: " << seconds << " s\n"
+     << "throughput: " << rate(documents) << " documents/s, "
+     << rate(sentences) << " sentences/s\n";
+  for (size_t i = 0; i < PipelineStageSize; ++i)
+  {
+    const auto stage = static_cast<PipelineStage>(i);
+    const auto stats = pipeline.GetStageStats(stage);
+    const auto workers = pipeline.GetConfig().workers[i];
+    os << "  " << PipelineStageName(stage) << ": " << workers
+       << " workers, " << stats.Throughput(workers) << " documents/s, busy "
+       << std::chrono::duration<double>(stats.busy).count() << " s, starved "
+       << std::chrono::duration<double>(stats.starved).count()
+       << " s, blocked "
+       << std::chrono::duration<double>(stats.blocked).count() << " s\n";
+  }
+  if (const auto &cache = pipeline.GetConfig().cache)
+  {
+    os << "cache: " << cache->GetHits() << " hits, " << cache->GetMisses()
+       << " misses\n";
+  }
+  if (const auto &vocabulary = pipeline.GetConfig().vocabulary)
   {
-    std::cout << sentnece.GetText() << std::endl;
+    os << "vocabulary: " << vocabulary->Size() << " terms, "
+       << vocabulary->GetHits() << " hits, " << vocabulary->GetMisses()
+       << " misses\n";
   }
+  os << "bottleneck: " << PipelineStageName(pipeline.GetBottleneck())
+     << std::endl;
+}
+} // namespace
 
-  // Set texts
-  double thereshold = 300;
+int main(int argc, char **argv)
+{
+  enum
+  {
+    OPT_WORKERS = 256,
+    OPT_QUEUE_CAPACITY,
+    OPT_IC_TABLE,
+    OPT_VECTORS,
+    OPT_PERSISTENT_WORKER,
+    OPT_NO_SHARED_VOCABULARY,
+    OPT_CACHE_SIZE,
+    OPT_CACHE_DIR,
+    OPT_SIMILARITY_DIR,
+    OPT_SIMILARITY_BAND,
+    OPT_TRACE,
+    OPT_CLIQUE_MODE,
+    OPT_ENGINE,
+    OPT_MAX_SEGMENT_LENGTH,
+    OPT_AUTO_PLAN,
+    OPT_DEADLINE,
+    OPT_NO_SMALL_DOCUMENTS
+  };
+  static const option long_options[] = {
+      {"list", required_argument, nullptr, 'l'},
+      {"output", required_argument, nullptr, 'o'},
+      {"threads", required_argument, nullptr, 'j'},
+      {"workers", required_argument, nullptr, OPT_WORKERS},
+      {"queue-capacity", required_argument, nullptr, OPT_QUEUE_CAPACITY},
+      {"threshold", required_argument, nullptr, 't'},
+      {"edge-budget", required_argument, nullptr, 'b'},
+      {"min-segment-size", required_argument, nullptr, 'm'},
+      {"clique-mode", required_argument, nullptr, OPT_CLIQUE_MODE},
+      {"engine", required_argument, nullptr, OPT_ENGINE},
+      {"max-segment-length", required_argument, nullptr,
+       OPT_MAX_SEGMENT_LENGTH},
+      {"auto-plan", no_argument, nullptr, OPT_AUTO_PLAN},
+      {"deadline", required_argument, nullptr, OPT_DEADLINE},
+      {"no-small-documents", no_argument, nullptr, OPT_NO_SMALL_DOCUMENTS},
+      {"ic-table", required_argument, nullptr, OPT_IC_TABLE},
+      {"vectors", required_argument, nullptr, OPT_VECTORS},
+      {"persistent-worker", no_argument, nullptr, OPT_PERSISTENT_WORKER},
+      {"no-shared-vocabulary", no_argument, nullptr,
+       OPT_NO_SHARED_VOCABULARY},
+      {"cache-size", required_argument, nullptr, OPT_CACHE_SIZE},
+      {"cache-dir", required_argument, nullptr, OPT_CACHE_DIR},
+      {"similarity-dir", required_argument, nullptr, OPT_SIMILARITY_DIR},
+      {"similarity-band", required_argument, nullptr, OPT_SIMILARITY_BAND},
+#ifdef GRAPHSEG_TRACE
+      {"trace", required_argument, nullptr, OPT_TRACE},
+#endif
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0}};
 
-  SegmentationContainer<UndirectedGraph<LangType>, VectorDim, LangType> seg(
-      text.GetSentences(), em);
+  Options options;
+  options.config.threshold = SimilarityType::DEFAULT_THRESHOLD;
+  bool valid = true;
+  int opt;
+  while ((opt = getopt_long(argc, argv, "l:o:j:t:b:m:h", long_options,
+                            nullptr)) != -1)
+  {
+    size_t n;
+    switch (opt)
+    {
+    case 'l':
+      options.lists.emplace_back(optarg);
+      break;
+    case 'o':
+      options.output = optarg;
+      break;
+    case 'j':
+      valid = ParseSize(optarg, n);
+      options.config.workers = {1, n, n, n};
+      break;
+    case OPT_WORKERS:
+      valid = ParseWorkers(optarg, options.config.workers);
+      break;
+    case OPT_QUEUE_CAPACITY:
+      valid = ParseSize(optarg, options.config.queue_capacity);
+      break;
+    case 't':
+      valid = ParseDouble(optarg, options.config.threshold);
+      break;
+    case 'b':
+      valid = ParseDouble(optarg, options.config.edge_budget) &&
+              options.config.edge_budget >= 0.0;
+      break;
+    case 'm':
+      valid = ParseSize(optarg, options.config.minimum_segment_size);
+      break;
+    case OPT_CLIQUE_MODE:
+      valid = ParseCliqueMode(optarg, options.config.clique_mode);
+      break;
+    case OPT_ENGINE:
+      valid = ParseEngine(optarg, options.config.engine);
+      break;
+    case OPT_MAX_SEGMENT_LENGTH:
+      valid = ParseSize(optarg, options.config.maximum_segment_length);
+      break;
+    case OPT_AUTO_PLAN:
+      options.config.automatic_plan = true;
+      break;
+    case OPT_DEADLINE:
+    {
+      size_t milliseconds = 0;
+      valid = ParseSize(optarg, milliseconds);
+      options.config.deadline = std::chrono::milliseconds(milliseconds);
+      break;
+    }
+    case OPT_NO_SMALL_DOCUMENTS:
+      options.config.small_documents = false;
+      break;
+    case OPT_IC_TABLE:
+      options.ic_table = optarg;
+      break;
+    case OPT_VECTORS:
+      options.vectors = optarg;
+      break;
+    case OPT_PERSISTENT_WORKER:
+      options.persistent_worker = true;
+      break;
+    case OPT_NO_SHARED_VOCABULARY:
+      options.shared_vocabulary = false;
+      break;
+    case OPT_CACHE_SIZE:
+      valid = ParseSize(optarg, options.cache_size);
+      break;
+    case OPT_CACHE_DIR:
+      options.cache_dir = optarg;
+      break;
+    case OPT_SIMILARITY_DIR:
+      options.config.similarity_dir = optarg;
+      break;
+    case OPT_SIMILARITY_BAND:
+      valid = ParseSize(optarg, options.config.similarity_band);
+      break;
+    case OPT_TRACE:
+      options.trace = optarg;
+      break;
+    case 'h':
+      Usage(argv[0], std::cout);
+      return 0;
+    default:
+      valid = false;
+    }
+    if (!valid)
+    {
+      if (optarg != nullptr)
+      {
+        std::cerr << argv[0] << ": invalid argument '" << optarg << "'\n";
+      }
+      Usage(argv[0], std::cerr);
+      return 2;
+    }
+  }
+  options.inputs.assign(argv + optind, argv + argc);
 
-  seg.SetThreshold(thereshold);
-  seg.SetGraph();
-  seg.Segmentation();
+  std::vector<std::string> paths;
+  try
+  {
+    for (const auto &input : options.inputs)
+    {
+      CollectPaths(input, paths);
+    }
+    for (const auto &list : options.lists)
+    {
+      if (list == "-")
+      {
+        ReadPathList(std::cin, paths);
+        continue;
+      }
+      std::ifstream ifs(list);
+      if (!ifs)
+      {
+        std::cerr << argv[0] << ": cannot open " << list << std::endl;
+        return 1;
+      }
+      ReadPathList(ifs, paths);
+    }
+    if (options.inputs.empty() && options.lists.empty())
+    {
+      ReadPathList(std::cin, paths);
+    }
+    if (!options.ic_table.empty())
+    {
+      options.config.ic_table =
+          std::make_shared<const internal::ICTable>(options.ic_table);
+    }
+    if (!options.vectors.empty())
+    {
+      options.config.vectors =
+          std::make_shared<const internal::VectorStore>(options.vectors);
+    }
+    if (options.shared_vocabulary)
+    {
+      options.config.vocabulary =
+          std::make_shared<internal::SharedVocabulary>();
+    }
+    if (!options.config.similarity_dir.empty())
+    {
+      std::filesystem::create_directories(options.config.similarity_dir);
+    }
+    if (options.cache_size > 0 || !options.cache_dir.empty())
+    {
+      options.config.cache = std::make_shared<internal::SegmentCache>(
+          options.cache_size, options.cache_dir);
+      options.config.model_id = ModelId(options.vectors, options.ic_table);
+    }
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << argv[0] << ": " << e.what() << std::endl;
+    return 1;
+  }
+
+  std::ofstream ofs;
+  if (!options.output.empty())
+  {
+    ofs.open(options.output);
+    if (!ofs)
+    {
+      std::cerr << argv[0] << ": cannot open " << options.output << std::endl;
+      return 1;
+    }
+  }
+  std::ostream &os = options.output.empty() ? std::cout : ofs;
 
-  for (const auto &segment : seg.GetSegment())
+  if (options.persistent_worker)
   {
-    for (const auto &sentence_idx : segment)
+    Executable<LangType>::StartPersistentWorker();
+  }
+
+  std::mutex mtx;
+  size_t documents = 0, failed = 0, sentences = 0;
+  PipelineType pipeline(options.config);
+  pipeline.Execute(paths, [&](PipelineType::Document &&document) {
+    std::ostringstream line;
+    WriteDocument(line, document);
+    std::lock_guard<std::mutex> lock(mtx);
+    os << line.str();
+    ++documents;
+    if (!document.error.empty())
+    {
+      ++failed;
+    }
+    else
     {
-      std::cout << text.GetSentences().at(sentence_idx).GetText() << std::endl;
+      sentences += document.sentences;
     }
+  });
+  os.flush();
+
+  if (options.persistent_worker)
+  {
+    Executable<LangType>::StopPersistentWorker();
   }
-  return 0;
+#ifdef GRAPHSEG_TRACE
+  if (!options.trace.empty())
+  {
+    internal::utils::Tracer::Instance().Dump(options.trace);
+  }
+#endif
+
+  WriteSummary(std::cerr, pipeline, documents, failed, sentences);
+  return failed == 0 ? 0 : 1;
 }
@@ -0,0 +1,94 @@
+#ifndef GRAPHSEG_CPP_SRC_OPTIONS_HPP
+#define GRAPHSEG_CPP_SRC_OPTIONS_HPP
+
+#include "graphseg/graphseg.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+/// <summary>
+/// option values shared by graphseg and graphseg_server
+/// </summary>
+namespace GraphSeg::cli
+{
+/// <summary>
+/// positive integer
+/// </summary>
+inline bool ParseSize(const char *s, size_t &value)
+{
+  char *end;
+  const auto v = std::strtoull(s, &end, 10);
+  if (*s == '\0' || *end != '\0' || v == 0)
+  {
+    return false;
+  }
+  value = static_cast<size_t>(v);
+  return true;
+}
+
+inline bool ParseDouble(const char *s, double &value)
+{
+  char *end;
+  value = std::strtod(s, &end);
+  return *s != '\0' && *end == '\0';
+}
+
+inline bool ParseCliqueMode(const std::string &s, graph::CliqueMode &mode)
+{
+  if (s == "exact")
+  {
+    mode = graph::CliqueMode::EXACT;
+  }
+  else if (s == "greedy")
+  {
+    mode = graph::CliqueMode::GREEDY;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+inline bool ParseEngine(const std::string &s, SegmentationEngine &engine)
+{
+  if (s == "clique")
+  {
+    engine = SegmentationEngine::CLIQUE;
+  }
+  else if (s == "coherence")
+  {
+    engine = SegmentationEngine::COHERENCE;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+/// <summary>
+/// cache keys must change with the model: path, size and mtime of its files
+/// </summary>
+inline std::string ModelId(const std::string &vectors,
+                           const std::string &ic_table)
+{
+  std::string id;
+  for (const auto &path : {vectors, ic_table})
+  {
+    id += path;
+    if (!path.empty())
+    {
+      id += ':' + std::to_string(std::filesystem::file_size(path)) + ':' +
+            std::to_string(std::filesystem::last_write_time(path)
+                               .time_since_epoch()
+                               .count());
+    }
+    id += '|';
+  }
+  return id;
+}
+} // namespace GraphSeg::cli
+
+#endif
@@ -0,0 +1,258 @@
+#include "graphseg/graphseg.hpp"
+#include "graphseg/server.hpp"
+#include "options.hpp"
+
+#include <chrono>
+#include <csignal>
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace GraphSeg;
+using namespace GraphSeg::graph;
+using namespace GraphSeg::cli;
+
+namespace
+{
+constexpr Lang LangType = Lang::JP;
+// dimension is taken from the loaded model
+constexpr int VectorDim = DynamicDim;
+#ifdef GRAPHSEG_CENTROID_SIMILARITY
+using SimilarityType = CentroidSimilarity;
+#else
+using SimilarityType = TermPairSimilarity;
+#endif
+
+using ServerType =
+    Server<UndirectedGraph<LangType>, VectorDim, LangType, SimilarityType>;
+
+ServerType *running_server = nullptr;
+
+void HandleSignal(int)
+{
+  if (running_server != nullptr)
+  {
+    running_server->Stop();
+  }
+}
+
+void Usage(const char *program, std::ostream &os)
+{
+  os << "usage: " << program << " --socket PATH [options]\n"
+     << "\n"
+     << "Serve segmentation requests on a Unix domain socket.\n"
+     << "\n"
+     << "  -s, --socket PATH        socket to listen on\n"
+     << "  -j, --threads N          requests served concurrently\n"
+     << "      --vectors FILE       embedding model in vector format\n"
+     << "      --ic-table FILE      precomputed information content table\n"
+     << "  -t, --threshold X        edge similarity threshold (default "
+     << SimilarityType::DEFAULT_THRESHOLD << ")\n"
+     << "  -b, --edge-budget X      keep at most X edges per sentence\n"
+     << "  -m, --min-segment-size N minimum sentences per segment\n"
+     << "      --clique-mode MODE   exact (default) or greedy, which bounds\n"
+     << "                           clique search time of dense documents\n"
+     << "      --engine NAME        clique (default) or coherence, which sets\n"
+     << "                           boundaries in O(N W) for long documents\n"
+     << "      --max-segment-length W\n"
+     << "                           longest segment of coherence engine\n"
+     << "      --auto-plan          choose edge band and clique mode of each\n"
+     << "                           document from sampled edge density\n"
+     << "      --deadline MS        answer each request within MS ms, cheaper\n"
+     << "                           work past that is flagged \"degraded\"\n"
+     << "      --no-small-documents segment requests of at most 128\n"
+     << "                           sentences on the general graph too\n"
+     << "      --persistent-worker  keep one python worker alive\n"
+     << "      --no-shared-vocabulary\n"
+     << "                           resolve terms of every request alone\n"
+     << "      --cache-size N       cache N results in memory\n"
+     << "      --cache-dir DIR      cache results on disk in DIR\n"
+     << "  -h, --help               show this help\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  enum
+  {
+    OPT_VECTORS = 256,
+    OPT_IC_TABLE,
+    OPT_PERSISTENT_WORKER,
+    OPT_NO_SHARED_VOCABULARY,
+    OPT_CACHE_SIZE,
+    OPT_CACHE_DIR,
+    OPT_CLIQUE_MODE,
+    OPT_ENGINE,
+    OPT_MAX_SEGMENT_LENGTH,
+    OPT_AUTO_PLAN,
+    OPT_DEADLINE,
+    OPT_NO_SMALL_DOCUMENTS
+  };
+  static const option long_options[] = {
+      {"socket", required_argument, nullptr, 's'},
+      {"threads", required_argument, nullptr, 'j'},
+      {"vectors", required_argument, nullptr, OPT_VECTORS},
+      {"ic-table", required_argument, nullptr, OPT_IC_TABLE},
+      {"threshold", required_argument, nullptr, 't'},
+      {"edge-budget", required_argument, nullptr, 'b'},
+      {"min-segment-size", required_argument, nullptr, 'm'},
+      {"clique-mode", required_argument, nullptr, OPT_CLIQUE_MODE},
+      {"engine", required_argument, nullptr, OPT_ENGINE},
+      {"max-segment-length", required_argument, nullptr,
+       OPT_MAX_SEGMENT_LENGTH},
+      {"auto-plan", no_argument, nullptr, OPT_AUTO_PLAN},
+      {"deadline", required_argument, nullptr, OPT_DEADLINE},
+      {"no-small-documents", no_argument, nullptr, OPT_NO_SMALL_DOCUMENTS},
+      {"persistent-worker", no_argument, nullptr, OPT_PERSISTENT_WORKER},
+      {"no-shared-vocabulary", no_argument, nullptr,
+       OPT_NO_SHARED_VOCABULARY},
+      {"cache-size", required_argument, nullptr, OPT_CACHE_SIZE},
+      {"cache-dir", required_argument, nullptr, OPT_CACHE_DIR},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0}};
+
+  ServerConfig config;
+  config.threshold = SimilarityType::DEFAULT_THRESHOLD;
+  std::string vectors, ic_table, cache_dir;
+  size_t cache_size = 0;
+  bool persistent_worker = false;
+  bool shared_vocabulary = true;
+  bool valid = true;
+  int opt;
+  while ((opt = getopt_long(argc, argv, "s:j:t:b:m:h", long_options,
+                            nullptr)) != -1)
+  {
+    switch (opt)
+    {
+    case 's':
+      config.socket_path = optarg;
+      break;
+    case 'j':
+      valid = ParseSize(optarg, config.threads);
+      break;
+    case OPT_VECTORS:
+      vectors = optarg;
+      break;
+    case OPT_IC_TABLE:
+      ic_table = optarg;
+      break;
+    case 't':
+      valid = ParseDouble(optarg, config.threshold);
+      break;
+    case 'b':
+      valid = ParseDouble(optarg, config.edge_budget) &&
+              config.edge_budget >= 0.0;
+      break;
+    case 'm':
+      valid = ParseSize(optarg, config.minimum_segment_size);
+      break;
+    case OPT_CLIQUE_MODE:
+      valid = ParseCliqueMode(optarg, config.clique_mode);
+      break;
+    case OPT_ENGINE:
+      valid = ParseEngine(optarg, config.engine);
+      break;
+    case OPT_MAX_SEGMENT_LENGTH:
+      valid = ParseSize(optarg, config.maximum_segment_length);
+      break;
+    case OPT_AUTO_PLAN:
+      config.automatic_plan = true;
+      break;
+    case OPT_DEADLINE:
+    {
+      size_t milliseconds = 0;
+      valid = ParseSize(optarg, milliseconds);
+      config.deadline = std::chrono::milliseconds(milliseconds);
+      break;
+    }
+    case OPT_NO_SMALL_DOCUMENTS:
+      config.small_documents = false;
+      break;
+    case OPT_PERSISTENT_WORKER:
+      persistent_worker = true;
+      break;
+    case OPT_NO_SHARED_VOCABULARY:
+      shared_vocabulary = false;
+      break;
+    case OPT_CACHE_SIZE:
+      valid = ParseSize(optarg, cache_size);
+      break;
+    case OPT_CACHE_DIR:
+      cache_dir = optarg;
+      break;
+    case 'h':
+      Usage(argv[0], std::cout);
+      return 0;
+    default:
+      valid = false;
+    }
+    if (!valid)
+    {
+      Usage(argv[0], std::cerr);
+      return 2;
+    }
+  }
+  if (config.socket_path.empty() || optind != argc)
+  {
+    Usage(argv[0], std::cerr);
+    return 2;
+  }
+
+  try
+  {
+    if (!vectors.empty())
+    {
+      config.vectors = std::make_shared<const internal::VectorStore>(vectors);
+    }
+    if (!ic_table.empty())
+    {
+      config.ic_table = std::make_shared<const internal::ICTable>(ic_table);
+    }
+    if (shared_vocabulary)
+    {
+      config.vocabulary = std::make_shared<internal::SharedVocabulary>();
+    }
+    if (cache_size > 0 || !cache_dir.empty())
+    {
+      config.cache =
+          std::make_shared<internal::SegmentCache>(cache_size, cache_dir);
+      config.model_id = ModelId(vectors, ic_table);
+    }
+    if (persistent_worker)
+    {
+      Executable<LangType>::StartPersistentWorker();
+    }
+
+    ServerType server(config);
+    running_server = &server;
+    std::signal(SIGINT, HandleSignal);
+    std::signal(SIGTERM, HandleSignal);
+    // a client disconnecting mid-response must not kill the server
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::cerr << "listening on " << config.socket_path << std::endl;
+    server.Run();
+    running_server = nullptr;
+    std::cerr << "served " << server.GetRequestCount() << " requests ("
+              << server.GetErrorCount() << " failed)" << std::endl;
+    if (config.cache)
+    {
+      std::cerr << "cache: " << config.cache->GetHits() << " hits, "
+                << config.cache->GetMisses() << " misses" << std::endl;
+    }
+    if (config.vocabulary)
+    {
+      std::cerr << "vocabulary: " << config.vocabulary->Size() << " terms, "
+                << config.vocabulary->GetHits() << " hits, "
+                << config.vocabulary->GetMisses() << " misses" << std::endl;
+    }
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << argv[0] << ": " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
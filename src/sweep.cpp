@@ -0,0 +1,299 @@
+#include "graphseg/graphseg.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace GraphSeg;
+using namespace GraphSeg::graph;
+
+namespace
+{
+constexpr Lang LangType = Lang::JP;
+
+// scores come from the matrix, embedding is never used
+template <class SimilarityPolicy>
+using ContainerType = SegmentationContainer<UndirectedGraph<LangType>,
+                                            DynamicDim, LangType,
+                                            SimilarityPolicy>;
+
+// matrices of at most 64 Words sentences
+template <size_t Words, class SimilarityPolicy>
+using SmallContainerType = SegmentationContainer<BitGraph<LangType, Words>,
+                                                 DynamicDim, LangType,
+                                                 SimilarityPolicy>;
+
+// sweep a container of the matrix, scored by SimilarityPolicy
+template <class SimilarityPolicy, class Sweep>
+auto SweepMatrix(
+    const std::shared_ptr<const internal::SimilarityMatrix> &matrix,
+    const Sweep &sweep)
+{
+  const auto words = BitGraphWords(matrix->Size());
+  if (words == 1)
+  {
+    return sweep(SmallContainerType<1, SimilarityPolicy>(matrix));
+  }
+  if (words == 2)
+  {
+    return sweep(SmallContainerType<2, SimilarityPolicy>(matrix));
+  }
+  return sweep(ContainerType<SimilarityPolicy>(matrix));
+}
+
+void Usage(const char *program, std::ostream &os)
+{
+  os << "usage: " << program << " -t LIST [options] file.gssm...\n"
+     << "\n"
+     << "Segment saved similarity matrices (graphseg --similarity-dir) for\n"
+     << "every combination of parameters and write one JSON line each.\n"
+     << "LIST is comma separated, e.g. -t 100,200,300\n"
+     << "\n"
+     << "  -t, --threshold LIST        edge similarity thresholds, negative\n"
+     << "                              only for centroid scores\n"
+     << "  -b, --edge-budget LIST      edges per sentence (default 0)\n"
+     << "  -m, --min-segment-size LIST minimum sentences per segment "
+        "(default 2)\n"
+     << "  -c, --clique-mode MODE      exact (default) or greedy\n"
+     << "  -e, --engine NAME           clique (default) or coherence\n"
+     << "  -w, --max-segment-length W  longest segment of coherence engine\n"
+     << "  -a, --auto-plan             choose edge band and clique mode of\n"
+     << "                              each matrix by sampled edge density\n"
+     << "  -h, --help                  show this help\n";
+}
+
+template <class T>
+bool ParseList(const char *s, std::vector<T> &values, bool negative = false)
+{
+  values.clear();
+  std::stringstream ss(s);
+  std::string item;
+  while (std::getline(ss, item, ','))
+  {
+    char *end;
+    const auto v = std::strtod(item.c_str(), &end);
+    if (item.empty() || *end != '\0' || (v < 0.0 && !negative))
+    {
+      return false;
+    }
+    values.emplace_back(static_cast<T>(v));
+  }
+  return !values.empty();
+}
+
+void WriteJsonString(std::ostream &os, const std::string &s)
+{
+  os << '"';
+  for (const auto c : s)
+  {
+    if (c == '"' || c == '\\')
+    {
+      os << '\\';
+    }
+    os << c;
+  }
+  os << '"';
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+  static const option long_options[] = {
+      {"threshold", required_argument, nullptr, 't'},
+      {"edge-budget", required_argument, nullptr, 'b'},
+      {"min-segment-size", required_argument, nullptr, 'm'},
+      {"clique-mode", required_argument, nullptr, 'c'},
+      {"engine", required_argument, nullptr, 'e'},
+      {"max-segment-length", required_argument, nullptr, 'w'},
+      {"auto-plan", no_argument, nullptr, 'a'},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0}};
+
+  std::vector<double> thresholds, edge_budgets{0.0};
+  std::vector<size_t> minimum_segment_sizes{2};
+  auto clique_mode = CliqueMode::EXACT;
+  auto engine = SegmentationEngine::CLIQUE;
+  size_t maximum_segment_length = 0;
+  bool automatic_plan = false;
+  bool valid = true;
+  int opt;
+  while ((opt = getopt_long(argc, argv, "t:b:m:c:e:w:ah", long_options,
+                            nullptr)) != -1)
+  {
+    switch (opt)
+    {
+    case 't':
+      // centroid cosines fall below zero
+      valid = ParseList(optarg, thresholds, true);
+      break;
+    case 'b':
+      valid = ParseList(optarg, edge_budgets);
+      break;
+    case 'm':
+      valid = ParseList(optarg, minimum_segment_sizes);
+      break;
+    case 'c':
+    {
+      const std::string mode = optarg;
+      valid = mode == "exact" || mode == "greedy";
+      clique_mode = mode == "greedy" ? CliqueMode::GREEDY : CliqueMode::EXACT;
+      break;
+    }
+    case 'e':
+    {
+      const std::string name = optarg;
+      valid = name == "clique" || name == "coherence";
+      engine = name == "coherence" ? SegmentationEngine::COHERENCE
+                                   : SegmentationEngine::CLIQUE;
+      break;
+    }
+    case 'w':
+    {
+      char *end;
+      maximum_segment_length = std::strtoull(optarg, &end, 10);
+      valid = *optarg != '\0' && *end == '\0';
+      break;
+    }
+    case 'a':
+      automatic_plan = true;
+      break;
+    case 'h':
+      Usage(argv[0], std::cout);
+      return 0;
+    default:
+      valid = false;
+    }
+    if (!valid)
+    {
+      Usage(argv[0], std::cerr);
+      return 2;
+    }
+  }
+  if (thresholds.empty() || optind == argc)
+  {
+    Usage(argv[0], std::cerr);
+    return 2;
+  }
+
+  const auto begin = std::chrono::steady_clock::now();
+  size_t runs = 0;
+  int status = 0;
+  for (int i = optind; i < argc; ++i)
+  {
+    const std::string path = argv[i];
+    std::shared_ptr<const internal::SimilarityMatrix> matrix;
+    try
+    {
+      matrix = std::make_shared<const internal::SimilarityMatrix>(
+          internal::SimilarityMatrix::Load(path));
+      if (matrix->Policy() != TermPairSimilarity::ID &&
+          matrix->Policy() != CentroidSimilarity::ID)
+      {
+        throw std::runtime_error(path + ": unknown similarity policy");
+      }
+      if (matrix->Policy() == TermPairSimilarity::ID &&
+          *std::min_element(thresholds.begin(), thresholds.end()) < 0.0)
+      {
+        throw std::runtime_error(path +
+                                 ": negative threshold for term-pair scores");
+      }
+    }
+    catch (const std::exception &e)
+    {
+      std::cerr << argv[0] << ": " << e.what() << std::endl;
+      status = 1;
+      continue;
+    }
+
+    // cliques are reused across thresholds, one sweep per other setting
+    std::vector<std::vector<std::vector<std::vector<internal::Vertex>>>>
+        results;
+    for (const auto edge_budget : edge_budgets)
+    {
+      for (const auto minimum_segment_size : minimum_segment_sizes)
+      {
+        if (matrix->Size() > 1)
+        {
+          const auto sweep = [&](auto &&container) {
+            container.SetEdgeBudget(edge_budget);
+            container.SetCliqueMode(clique_mode);
+            container.SetSegmentationEngine(engine);
+            container.SetMaximumSegmentLength(maximum_segment_length);
+            container.SetAutomaticPlan(automatic_plan);
+            container.SetMinimumSegmentSize(minimum_segment_size);
+            return container.SweepThresholds(thresholds);
+          };
+          if (matrix->Policy() == CentroidSimilarity::ID)
+          {
+            results.emplace_back(
+                SweepMatrix<CentroidSimilarity>(matrix, sweep));
+          }
+          else
+          {
+            results.emplace_back(
+                SweepMatrix<TermPairSimilarity>(matrix, sweep));
+          }
+        }
+        else
+        {
+          const std::vector<std::vector<internal::Vertex>> segments =
+              matrix->Size() == 1
+                  ? std::vector<std::vector<internal::Vertex>>{{0}}
+                  : std::vector<std::vector<internal::Vertex>>{};
+          results.emplace_back(thresholds.size(), segments);
+        }
+      }
+    }
+
+    for (size_t t = 0; t < thresholds.size(); ++t)
+    {
+      for (size_t b = 0; b < edge_budgets.size(); ++b)
+      {
+        for (size_t m = 0; m < minimum_segment_sizes.size(); ++m)
+        {
+          const auto &segments =
+              results[b * minimum_segment_sizes.size() + m][t];
+          ++runs;
+
+          std::cout << "{\"path\":";
+          WriteJsonString(std::cout, path);
+          std::cout << ",\"threshold\":" << thresholds[t]
+                    << ",\"edge_budget\":" << edge_budgets[b]
+                    << ",\"minimum_segment_size\":"
+                    << minimum_segment_sizes[m]
+                    << ",\"sentences\":" << matrix->Size()
+                    << ",\"segments\":[";
+          bool first = true;
+          for (const auto &segment : segments)
+          {
+            if (segment.empty())
+            {
+              continue;
+            }
+            const auto [lo, hi] =
+                std::minmax_element(segment.begin(), segment.end());
+            std::cout << (first ? "" : ",") << '[' << *lo << ','
+                      << *hi + 1 << ']';
+            first = false;
+          }
+          std::cout << "]}\n";
+        }
+      }
+    }
+  }
+  std::cout.flush();
+
+  std::cerr << runs << " segmentations in "
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                             begin)
+                   .count()
+            << " s" << std::endl;
+  return status;
+}